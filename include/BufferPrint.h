@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Print into a caller-provided buffer, no allocation. Output that does not fit is dropped and marks the buffer as
+ * overflowed; truncate() rolls back to an earlier length, e.g. to drop an entry that did not fit completely.
+ */
+class BufferPrint final : public Print {
+ public:
+  BufferPrint(uint8_t* buffer, const size_t capacity) : buffer_(buffer), capacity_(capacity) {}
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* data, size_t size) override {
+    if (size > capacity_ - length_) {
+      overflowed_ = true;
+      return 0;
+    }
+    memcpy(buffer_ + length_, data, size);
+    length_ += size;
+    return size;
+  }
+  using Print::write;
+
+  void truncate(const size_t length) {
+    length_     = length < length_ ? length : length_;
+    overflowed_ = false;
+  }
+
+  [[nodiscard]] uint8_t*       data() { return buffer_; }
+  [[nodiscard]] const uint8_t* data() const { return buffer_; }
+  [[nodiscard]] size_t         length() const { return length_; }
+  [[nodiscard]] size_t         remaining() const { return capacity_ - length_; }
+  [[nodiscard]] bool           overflowed() const { return overflowed_; }
+
+ private:
+  uint8_t*     buffer_;
+  size_t       capacity_;
+  size_t       length_     = 0;
+  bool         overflowed_ = false;
+};
+
+// Print that only counts the bytes, to measure output before streaming it, e.g. for a Content-Length header
+class LengthPrint final : public Print {
+ public:
+  size_t write(uint8_t) override { return 1; }
+  size_t write(const uint8_t*, const size_t size) override { return size; }
+  using Print::write;
+};
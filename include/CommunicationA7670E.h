@@ -4,8 +4,16 @@
 #include <TinyGsmClient.h>
 #include <ArduinoHttpClient.h>
 
+#include "GzipEncoder.h"
 #include "ICommunicationService.h"
-
+#include "PowerSavingGrant.h"
+#include "UploadEncoder.h"
+
+/**
+ * SIMCom A7670E over TinyGSM. With MODEM_POWER_SAVING the modem asks the network for PSM and eDRX; when PSM is granted
+ * it is left attached and asleep after the session (AT+CSCLK=1, DTR high, pins held through deep sleep) and the next
+ * session only wakes it with DTR. A modem that does not answer or lost its registration gets the full power-on.
+ */
 class CommunicationA7670E final : public ICommunicationService {
  public:
   explicit CommunicationA7670E()
@@ -18,22 +26,31 @@ class CommunicationA7670E final : public ICommunicationService {
 
   CommunicationA7670E(const CommunicationA7670E&)            = delete;
   CommunicationA7670E& operator=(const CommunicationA7670E&) = delete;
-  int                  getSignalStrengthPercentage() override;
   void                 powerOffModemImpl() override;
 
-  void sendMPPTPayload() override;
+  void sendMPPTPayload(UploadFormat format) override;
   void downloadConfig() override;
   void performOtaUpdate() override;
 
  protected:
-  void setupModemImpl() override;
+  bool setupModemImpl() override;
 
  private:
+  void             captureRadioMetrics(RegStatus status);
+  bool             wakeFromSleep();
+  void             requestPowerSaving();
+  PowerSavingGrant readPowerSavingGrant();
+  void             sleepAttached();
+  int  postTelegrafBatch(UploadEncoder& encoder, const String& authorization, GzipEncoder* gzip);
+
   TinyGsm       modem;
   TinyGsmClient tinyGsmClient;
   HttpClient    clientTelegraf;
   HttpClient    clientFastApi;
   // StreamDebugger debugger;
+
+  bool        psmGranted_ = false;  // this session, powerOffModemImpl() lets the modem sleep instead of powering it off
+  static bool asleep_;              // attached and asleep since the last session (RTC memory)
 };
 
 #endif
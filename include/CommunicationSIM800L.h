@@ -18,19 +18,21 @@ class CommunicationSIM800L final : public ICommunicationService {
 
   CommunicationSIM800L(const CommunicationSIM800L&)             = delete;
   CommunicationSIM800L&  operator=(const CommunicationSIM800L&) = delete;
-  int                    getSignalStrengthPercentage() override;
   void                   powerOffModemImpl() override;
   std::optional<timeval> getTimeFromModem() override;
 
-  void sendMPPTPayload() override;
+  void sendMPPTPayload(UploadFormat format) override;
   void downloadConfig() override;
 
  protected:
-  void setupModemImpl() override;
+  bool setupModemImpl() override;
   bool ensureNetwork();
 
  private:
-  static bool   setupPMU();
+  static bool setupPMU();
+  template <typename Item>
+  int postJson(const Item& item);
+
   TinyGsm       modem;
   TinyGsmClient tinyGsmClient;
   HttpClient    httpClientTelegraf;
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <time.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Globals.h"
+#include "WakeProfiler.h"
+
+enum class EnergyConsumer : uint8_t { Cpu, ModemRegister, ModemTransmit, Rs485, DeepSleep, Count };
+
+constexpr size_t      ENERGY_CONSUMER_COUNT = static_cast<size_t>(EnergyConsumer::Count);
+constexpr const char* ENERGY_CONSUMER_NAMES[ENERGY_CONSUMER_COUNT] = {"cpu", "modem_register", "modem_transmit",
+                                                                      "rs485", "sleep"};
+
+// mean current of each consumer at the board supply, in mA
+struct EnergyCurrents {
+  float cpuActive;
+  float modemRegister;  // powered up and registering, or attached and idle between transfers
+  float modemTransmit;  // HTTP transfers
+  float rs485;          // transceiver while polling the MPPT
+  float deepSleep;      // whole board
+};
+
+constexpr EnergyCurrents DEFAULT_ENERGY_CURRENTS = {ENERGY_CPU_ACTIVE_MA, ENERGY_MODEM_REGISTER_MA,
+                                                    ENERGY_MODEM_TRANSMIT_MA, ENERGY_RS485_MA, ENERGY_DEEP_SLEEP_MA};
+
+struct WakeCharge {
+  float mAs[ENERGY_CONSUMER_COUNT];
+
+  [[nodiscard]] float total() const;
+};
+
+/**
+ * Estimates the charge of one wake cycle from its phase durations:
+ * - CPU: the whole wake.
+ * - modem registering: from the modem start to the end of the modem wait, during which loop() runs the Modbus poll
+ *   and log append next to the setup, and the sleep entry, which powers it off.
+ * - modem transmitting: config download, OTA check and upload.
+ * - RS485: every Modbus transaction of the wake.
+ * - deep sleep: the sleep that follows the wake.
+ * Consumers draw at the same time, so their charges add up.
+ */
+class EnergyModel {
+ public:
+  explicit EnergyModel(const EnergyCurrents& currents) : currents_(currents) {}
+
+  [[nodiscard]] WakeCharge wakeCharge(const uint32_t (&phaseUs)[WAKE_PHASE_COUNT], uint32_t sleepSeconds) const;
+
+  static float toMilliwattHours(const float mAs, const float volts) { return mAs * volts / 3600.0f; }
+
+ private:
+  EnergyCurrents currents_;
+};
+
+/**
+ * Energy summary sent with the WakeReport of an upload: the charge of the last finished wake and the energy per
+ * consumer since local midnight, the day boundary of the MPPT's own daily counters (0x3304 consumed energy today).
+ */
+struct EnergySummary {
+  // upper bound of the printed summary, the line protocol fields being the longest form
+  static constexpr size_t MAX_PRINT_LENGTH = 128 + ENERGY_CONSUMER_COUNT * 48;
+
+  float wakeMas;  // 0 until the first wake was accounted
+  float todayMwh[ENERGY_CONSUMER_COUNT];
+
+  [[nodiscard]] float todayTotalMwh() const;
+};
+
+/**
+ * Daily energy totals in RTC memory. addWake() is called once per wake, right before deep sleep; the totals restart
+ * at local midnight once the clock is set.
+ */
+class EnergyLedger {
+ public:
+  static void          addWake(const WakeCharge& charge, time_t now);
+  static EnergySummary summary();
+};
@@ -16,10 +16,11 @@
 #endif
 
 #include <HardwareSerial.h>
-#include <ModbusMaster.h>
 
-extern HardwareSerial RS485Serial;
-extern ModbusMaster   node;
+#include "ModbusRtuMaster.h"
+
+extern HardwareSerial  RS485Serial;
+extern ModbusRtuMaster node;
 class ICommunicationService;
 extern ICommunicationService* communicationService;
 class TimeService;
@@ -35,18 +36,55 @@ extern LoadController loadController;
 #define DEEP_SLEEP_DURATION 120   /* Time ESP32 will go to sleep (in seconds) */
 
 #define SEND_INTERVAL_SEC (15 * 60) /* 15 mins */
+#define MODEM_TASK_STACK 8192       /* bytes, task bringing the modem up next to the MPPT poll */
+
+// modem session budget and per-stage deadlines, see ModemSession.h
+#define MODEM_SESSION_BUDGET_MS 240000        /* whole modem session of a wake, below the 300 s task watchdog */
+#define MODEM_DEADLINE_POWER_ON_MS 20000      /* power-on until the modem answers AT */
+#define MODEM_DEADLINE_WAKE_MS 3000           /* modem asleep in PSM answering AT after DTR */
+#define MODEM_DEADLINE_SIM_MS 10000           /* SIM ready, unlocked */
+#define MODEM_DEADLINE_REGISTRATION_MS 90000  /* network registration */
+#define MODEM_DEADLINE_PDP_MS 30000           /* APN and data connection */
+#define MODEM_DEADLINE_TRANSFER_MS 60000      /* each HTTP exchange */
+#define MODEM_DEADLINE_OTA_MS 180000          /* firmware image download */
+#define MODEM_RETRY_BACKOFF_SEC SEND_INTERVAL_SEC /* wait after a failed session, doubled per failure in a row */
+#define MODEM_RETRY_BACKOFF_MAX_SEC (4 * 3600)
 #define CUTOFF_HIGH_WINTER 60.0f
 #define CUTOFF_LOW_WINTER 50.0f
 #define CUTOFF_HIGH_SUMMER 50.0f
 #define CUTOFF_LOW_SUMMER 40.0f
 
-#define MPPT_LOG_FILE_NAME "/mppt_log.log"
+#define MPPT_LOG_DIR "/log"            /* append-only segment files <n>.bin */
+#define MPPT_LOG_SEGMENT_BYTES 16384  /* a segment is closed once it reaches this size */
+#define MPPT_LOG_STATE "log_state"    /* Preferences key of the acknowledged cursor */
+#define MPPT_RTC_SAMPLE_CAPACITY 12   /* samples buffered in RTC memory before they are written to the log */
+#define MPPT_LOG_PARTITION_LABEL "mpptlog" /* data partition used with -DMPPT_LOG_PARTITION */
+#define MPPT_LEGACY_LOG_FILE_NAME "/mppt_log.log" /* JSON lines, written by firmware <= 1.1.6 */
 #define MY_ESP_DEVICE_ID "crss"
 #define PREF_NAME "crss-pref"
 #define FAILED_LINES_COUNT "failed_lines_c"
+#define MPPT_UPLOAD_BATCH_RECORDS 30   /* max log entries per Telegraf POST */
+#define MPPT_UPLOAD_BATCH_BYTES 16384  /* max JSON body size per Telegraf POST */
+#define MPPT_UPLOAD_GZIP true          /* gzip batches (Content-Encoding: gzip), needs PSRAM */
+#define MPPT_UPLOAD_FORMAT UploadFormat::Json /* unless the config sets uploadFormat, see UploadFormat.h */
+#define MPPT_UPLOAD_CHUNK_RECORDS 240  /* max log entries per columnar chunk */
+#define MPPT_LINE_PROTOCOL_MEASUREMENT "mppt" /* measurement name of line protocol uploads */
+#define MPPT_WAKE_PROFILE true         /* per-phase wake timings in the telemetry, see WakeProfiler.h */
+#define MPPT_WAKE_PROFILE_WINDOW 30    /* wakes per min / mean / max window of the wake profile */
+
+// energy model of the wake profile: mean currents at the board supply, see EnergyModel.h
+#define ENERGY_SUPPLY_VOLTAGE 3.7f       /* V, board supply (18650 cell) */
+#define ENERGY_CPU_ACTIVE_MA 45.0f       /* ESP32 awake, Wi-Fi / BT off */
+#define ENERGY_MODEM_REGISTER_MA 110.0f  /* A7670E powered up, registering or attached idle */
+#define ENERGY_MODEM_TRANSMIT_MA 240.0f  /* A7670E during HTTP transfers */
+#define ENERGY_RS485_MA 8.0f             /* RS485 transceiver while polling */
+#define ENERGY_DEEP_SLEEP_MA 0.9f        /* whole board in deep sleep, modem off */
 
 #define HTTP_TELEGRAF_SERVER "telegraf-mppt.igerko.com"
 #define HTTP_TELEGRAF_RESOURCE_MPPT "/crss"
+#define HTTP_TELEGRAF_RESOURCE_MPPT_CHUNK "/crss/chunk" /* columnar chunks, expanded by the backend */
+#define HTTP_TELEGRAF_RESOURCE_MPPT_LINE "/crss/write?precision=s" /* influx line protocol, influxdb_listener */
+#define HTTP_TELEGRAF_RESOURCE_MPPT_MSGPACK "/crss/msgpack" /* MessagePack, xpath_msgpack parser */
 #define HTTP_TELEGRAF_PORT 80
 
 #define HTTP_MPPT_SERVER "mppt.igerko.com"
@@ -102,6 +140,11 @@ extern LoadController loadController;
 
 #define MODEM_BAUDRATE (115200)
 #define MODEM_DTR_PIN (25)
+// keep the modem attached and asleep (PSM, DTR high) between sessions instead of powering it off
+#define MODEM_POWER_SAVING true
+#define MODEM_PSM_PERIODIC_TAU "00100001" /* requested T3412: 1 h, GPRS timer 3, above SEND_INTERVAL_SEC */
+#define MODEM_PSM_ACTIVE_TIME "00000101"  /* requested T3324: 10 s, GPRS timer 2 */
+#define MODEM_EDRX_CYCLE "0101"           /* requested LTE eDRX cycle: 81.92 s */
 #define MODEM_TX_PIN (26)
 #define MODEM_RX_PIN (27)
 // The modem boot pin needs to follow the startup sequence.
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp32/rom/miniz.h>
+
+/**
+ * Gzip (RFC 1952) encoder for upload batches, using the deflate compressor in the ESP32 ROM.
+ *
+ * The compressor state (a few hundred kB, dominated by the 32 kB window and its hash chains) and the output buffer are
+ * allocated in PSRAM once per upload session and reused for every batch. A batch is compressed in one call, memory
+ * use is bounded by the batch size.
+ */
+class GzipEncoder {
+ public:
+  explicit GzipEncoder(size_t maxInputSize);
+  ~GzipEncoder();
+  GzipEncoder(const GzipEncoder&)            = delete;
+  GzipEncoder& operator=(const GzipEncoder&) = delete;
+
+  bool                         begin();
+  size_t                       compress(const uint8_t* data, size_t length);  // 0 if the result does not fit
+  [[nodiscard]] const uint8_t* data() const { return output_; }
+
+ private:
+  static constexpr size_t HEADER_SIZE  = 10;
+  static constexpr size_t TRAILER_SIZE = 8;
+
+  size_t            capacity_;
+  tdefl_compressor* compressor_ = nullptr;
+  uint8_t*          output_     = nullptr;
+};
@@ -1,38 +1,62 @@
 // IModem.h
 #pragma once
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/task.h>
+
 #include "Globals.h"
+#include "ModemSession.h"
+#include "RadioMetrics.h"
 #include "TimeService.h"
-#include "TinyGsmClient.h"
-#include "secrets.h"
-
+#include "UploadFormat.h"
+#include "WakeProfiler.h"
+
+/**
+ * Modem session of one wake.
+ *
+ * startModem() runs the power-up and network registration (setupModemImpl()) in a task on the core the Arduino loop
+ * does not use, so the MPPT can be read and the sample logged meanwhile. waitForModem() joins it: it blocks for
+ * whatever registration time is left and publishes the session's radio metrics. Nothing but the task touches the modem
+ * before the join.
+ *
+ * The bring-up runs against the ModemSession deadlines: a setupModemImpl() that gives up returns false, the modem is
+ * powered off at the join and the session counts as failed.
+ */
 class ICommunicationService {
  public:
   virtual ~ICommunicationService() = default;
 
-  virtual int getSignalStrengthPercentage() = 0;
-
-  virtual void downloadConfig()  = 0;
-  virtual void sendMPPTPayload() = 0;
-  virtual void performOtaUpdate() = 0;
-
-  void setupModem() {
-    setupModemImpl();
-    isModemOn_ = true;
-  }
+  virtual void downloadConfig()                      = 0;
+  virtual void sendMPPTPayload(UploadFormat format) = 0;  // uploads the log from the acknowledged cursor on
+  virtual void performOtaUpdate()                    = 0;
 
-  void powerOffModem() {
-    if (isModemOn_)
-      powerOffModemImpl();
-    isModemOn_ = false;
-  }
+  void startModem();
+  bool waitForModem();  // returns isModemOn()
+  void powerOffModem();
 
   [[nodiscard]] bool isModemOn() const { return isModemOn_; }
+  [[nodiscard]] bool isModemStarting() const { return modemTask_ != nullptr; }
+  // of the last modem session that was joined (kept across deep sleep), no modem I/O
+  [[nodiscard]] static const RadioMetrics& radioMetrics() { return sessionRadioMetrics_; }
 
  protected:
-  virtual void setupModemImpl()    = 0;
+  virtual bool setupModemImpl()    = 0;  // false: a stage ran out of time or failed for good
   virtual void powerOffModemImpl() = 0;
 
+  RadioMetrics radioMetrics_;  // captured once per session by setupModemImpl()
+
  private:
-  bool isModemOn_ = false;
+  static constexpr EventBits_t MODEM_READY = 0x01;
+
+  static void modemTask(void* service);
+  void        finishSetup();  // publishes the session, powers the modem off if it did not come up
+
+  static RadioMetrics sessionRadioMetrics_;
+
+  TaskHandle_t       modemTask_    = nullptr;
+  EventGroupHandle_t modemEvents_  = nullptr;
+  uint32_t           modemSetupUs_ = 0;
+  bool               modemReady_   = false;  // result of setupModemImpl()
+  bool               isModemOn_    = false;
 };
@@ -3,6 +3,8 @@
 
 #include <Preferences.h>
 
+#include "UploadFormat.h"
+
 class LoadController {
  public:
   LoadController();
@@ -10,6 +12,9 @@ class LoadController {
   void updateConfigAndTime(const String& payload);
   void setLoadBasedOnConfig() const;
 
+  // format of the next upload: the one the config chose, MPPT_UPLOAD_FORMAT if it chose none
+  static UploadFormat uploadFormat();
+
   void setNextLoadOn(time_t t) { nextLoadOn_ = t; }
   void setNextLoadOff(time_t t) { nextLoadOff_ = t; }
 
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "LoggingService.h"
+
+/**
+ * Columnar encoding of a run of LogEntry samples ("MC" chunk), for uploading long backlogs.
+ *
+ * The header names the device and firmware and lists the registers (address, type, decimals), so a chunk can be
+ * expanded without the firmware sources; tools/log_chunk_decode.py is the reference decoder. Every field is then
+ * stored as one column over all samples: the first value as a zig-zag varint, each following one as a varint token
+ *   - low bit 0: delta to the previous value, zig-zag encoded in the upper bits
+ *   - low bit 1: the previous delta repeats (upper bits) times; the delta before the first token counts as 0
+ * so unchanged values cost one token per run and steadily counting ones (timestamps, energy) as well.
+ *
+ * Register columns hold the signed register value, invalid ones are dropped again via the validity mask column. The
+ * link counter and RadioMetrics columns follow the registers.
+ */
+class LogChunkEncoder {
+ public:
+  static constexpr uint8_t MAGIC[2] = {'M', 'C'};
+  static constexpr uint8_t VERSION  = 2;  // 2: radio columns
+
+  static constexpr size_t ENTRY_COLUMNS = 6;  // ts, load, signal, wake time, modem sync, validity mask
+  static constexpr size_t LINK_COLUMNS  = 7;  // tx, timeout, crc, exception, reset, skipped, breaker
+  static constexpr size_t RADIO_COLUMNS = 9;  // registration, access, mcc, mnc, area, cell, rsrp, rsrq, sinr
+  static constexpr size_t COLUMNS       = ENTRY_COLUMNS + mpptReadRegistersCount + LINK_COLUMNS + RADIO_COLUMNS;
+  static constexpr size_t MAX_VARINT    = 10;
+
+  static constexpr size_t maxEncodedSize(size_t samples) {
+    return sizeof(MAGIC) + 1 + 2 * 256 + MAX_VARINT + 1 + 3 * mpptReadRegistersCount + samples * COLUMNS * MAX_VARINT;
+  }
+
+  // returns the chunk size, 0 if it does not fit into capacity
+  static size_t encode(const LogEntry* entries, size_t count, uint8_t* out, size_t capacity);
+
+ private:
+  static int64_t columnValue(const LogEntry& entry, size_t column);
+  static int64_t radioValue(const RadioMetrics& radio, size_t column);
+};
@@ -2,9 +2,15 @@
 
 #include <ArduinoJson.h>
 
+#include <type_traits>
+
+#include "EnergyModel.h"
 #include "Globals.h"
 #include "LittleFS.h"
-#include "map"
+#include "MPPTRegisters.h"
+#include "ModbusLinkHealth.h"
+#include "RadioMetrics.h"
+#include "WakeProfiler.h"
 
 namespace AdditionalJSONKeys {
 constexpr auto TIMESTAMP        = "ts";
@@ -15,24 +21,179 @@ constexpr auto TOTAL_WAKE_TIME  = "total_wake_time";
 constexpr auto LOAD_STATUS      = "load_status";
 constexpr auto MODEM_SYNC_TIME  = "modem_sync_time";
 constexpr auto FIRMWARE_VERSION = "firmware_version";
+constexpr auto RS485            = "rs485";
+constexpr auto RADIO            = "radio";
+constexpr auto PROFILE          = "profile";
+constexpr auto PROFILE_WINDOW   = "profile_window";
+constexpr auto ENERGY           = "energy";
 }  // namespace AdditionalJSONKeys
 
 class LogEntry {
  public:
+  LogEntry() = default;
   explicit LogEntry(time_t ts, int loadState);
-  [[nodiscard]] String toJson() const;
-  void                 addValue(uint16_t regAddr, float regVal);
+
+  // upper bound of printJson() and printLineProtocol() output
+  static constexpr size_t MAX_PRINT_LENGTH = 480 + sizeof(MY_ESP_DEVICE_ID) + sizeof(MPPT_FIRMWARE_VERSION) +
+                                             sizeof(MPPT_LINE_PROTOCOL_MEASUREMENT) +
+                                             mpptReadRegistersCount * (RegisterJsonKey::LENGTH + 22);
+
+  size_t               printJson(Print& out) const;
+  size_t               printLineProtocol(Print& out) const;
+  void                 toDocument(JsonDocument& doc, bool numericRegisters = false) const;
+  static bool          fromLegacyJson(const String& line, LogEntry& entry);
+  void                 setValues(const RegisterValues& registerValues) { values = registerValues; }
+  void                 setLinkCounters(const LinkErrorCounters& counters) { linkCounters = counters; }
+
+ private:
+  friend class LogChunkEncoder;
+  friend struct WakeReport;
+
+  uint32_t          ts;
+  int32_t           loadState;
+  uint32_t          totalWakeTime;  // seconds
+  uint32_t          modemSyncTime;
+  RegisterValues    values;
+  LinkErrorCounters linkCounters;
+  RadioMetrics      radio;  // of the modem session the sample was taken in, defaults when the modem was off
+};
+static_assert(std::is_trivially_copyable_v<LogEntry>, "LogEntry is stored as a plain copy");
+
+/**
+ * Wake profile and energy summary of the device at upload time. They describe the wakes rather than a sample, so the
+ * stored records do not carry them: every upload session sends one report as the first item of its first batch.
+ * Empty before the first wake was profiled, and always with MPPT_WAKE_PROFILE false.
+ */
+struct WakeReport {
+  // upper bound of printJson() and printLineProtocol() output
+  static constexpr size_t MAX_PRINT_LENGTH = 96 + sizeof(MY_ESP_DEVICE_ID) + sizeof(MPPT_FIRMWARE_VERSION) +
+                                             sizeof(MPPT_LINE_PROTOCOL_MEASUREMENT) + WakeProfile::MAX_PRINT_LENGTH +
+                                             EnergySummary::MAX_PRINT_LENGTH;
+
+  uint32_t      ts;
+  WakeProfile   profile;
+  EnergySummary energy;
+  float         loadShare;  // firmware energy today in % of the MPPT's load energy today (0x3304), negative if unknown
+
+  static WakeReport  capture();
+  [[nodiscard]] bool isEmpty() const;
+  size_t             printJson(Print& out) const;
+  size_t             printLineProtocol(Print& out) const;
+  void               toDocument(JsonDocument& doc) const;
+};
+
+/**
+ * On-flash form of a LogEntry: fixed size, versioned, with a CRC-32 over header and entry. Records are appended
+ * back to back, so a torn or corrupted record can be skipped without losing the ones after it.
+ */
+struct LogRecord {
+  static constexpr uint16_t MAGIC   = 0x4D4C;  // "LM"
+  // 2: RadioMetrics instead of the signal percentage, 3: WakeProfile, EnergySummary, 4: modem_wait phase,
+  // 5: profile and energy moved to the WakeReport
+  static constexpr uint8_t  VERSION = 5;
+
+  uint16_t magic;
+  uint8_t  version;
+  uint8_t  reserved;
+  uint16_t size;  // sizeof(LogRecord), guards against layout changes without a version bump
+  uint16_t reserved2;
+  LogEntry entry;
+  uint32_t crc;
+
+  static LogRecord   fromEntry(const LogEntry& entry);
+  [[nodiscard]] bool isValid() const;
+};
+static_assert(std::is_trivially_copyable_v<LogRecord>, "LogRecord is written as raw bytes");
+
+/**
+ * Position in the log. With the LittleFS store: segment number and byte offset inside that segment. With the
+ * partition store (MPPT_LOG_PARTITION): sequence number of the next record in `segment`, `offset` is unused.
+ */
+struct LogCursor {
+  uint32_t segment = 0;
+  uint32_t offset  = 0;
+};
+
+/**
+ * Iterates the log from a cursor onwards, moving on to the next segment when one is exhausted, and then over the
+ * samples still buffered in RTC memory.
+ */
+class LogReader {
+ public:
+  explicit LogReader(const LogCursor& start) : cursor_(start) {}
+  ~LogReader();
+  LogReader(const LogReader&)            = delete;
+  LogReader& operator=(const LogReader&) = delete;
+
+  bool                    next(LogEntry& entry);
+  [[nodiscard]] LogCursor position() const { return cursor_; }  // just behind the last returned stored entry
+  [[nodiscard]] size_t    pendingRead() const { return pendingRead_; }  // buffered samples returned so far
 
  private:
-  uint32_t                  ts;
-  int                       loadState;
-  std::map<uint16_t, float> values;
+  bool nextStored(LogEntry& entry);
+
+  LogCursor cursor_;
+  size_t    pendingRead_ = 0;
+  bool      storeDone_   = false;
+#ifndef MPPT_LOG_PARTITION
+  File file_;
+  bool opened_ = false;
+#endif
 };
 
+/**
+ * Append-only log of LogEntry records. Uploads never rewrite it: they advance the acknowledged cursor (persisted in
+ * Preferences) and storage behind the cursor is released.
+ *
+ * New samples are first buffered as LogRecords in RTC memory, which survives deep sleep, and written to the store in
+ * one go when the buffer is full or after a reset that was not a deep sleep wake-up (brownout, watchdog). Uploads read
+ * the buffered samples after the stored ones and drop them once accepted, so samples taken between two modem sessions
+ * usually never reach flash. The store itself is only opened (LittleFS mount, cursor from NVS) when it is needed.
+ *
+ * The store is chosen at build time:
+ * - default: segment files in MPPT_LOG_DIR on LittleFS (LogStoreLittleFS.cpp), whole segments are deleted once
+ *   acknowledged.
+ * - MPPT_LOG_PARTITION: a circular log in the raw MPPT_LOG_PARTITION_LABEL data partition (LogStorePartition.cpp),
+ *   the oldest sector is erased when the log wraps around.
+ */
 class LoggingService {
  public:
   LoggingService() = default;
   static void   setup();
   static size_t logMPPTEntryToFile(const LogEntry& log);
   static bool   clearLogFile();
+
+  static void   flushPendingSamples();
+  static size_t pendingSamples();
+  static bool   pendingSample(size_t index, LogEntry& entry);
+  static void   dropPendingSamples(size_t count);
+#ifdef MPPT_SERIALIZER_BENCH
+  static void benchmarkSerializers(const LogEntry& entry);
+#endif
+
+  static LogCursor acknowledgedCursor();
+  static void      acknowledge(const LogCursor& cursor);
+
+#ifndef MPPT_LOG_PARTITION
+  static bool     readLogEntry(File& file, LogEntry& log);
+  static uint32_t writeSegment() { return state_.writeSegment; }
+  static String   segmentPath(uint32_t segment);
+#endif
+
+ private:
+  struct LogState {
+    LogCursor acknowledged;
+    uint32_t  writeSegment = 0;  // LittleFS store only
+  };
+
+  static bool   openStore();
+  static bool   setupStore();  // false if the store cannot be used yet (LittleFS mount failed)
+  static size_t storeRecords(const LogRecord* records, size_t count);  // returns the number of records consumed
+  static void   saveState();
+#ifndef MPPT_LOG_PARTITION
+  static void migrateLegacyLog();
+#endif
+
+  static LogState state_;
+  static bool     storeOpen_;
 };
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+#include "ModbusReadPlan.h"
+
+enum RegType { REG_U16, REG_U32, REG_S16, REG_S32 };
+
+struct RegisterInfo {
+  uint16_t    address;
+  const char* name;
+  float       scale;
+  RegType     type;
+};
+
+constexpr uint16_t registerWords(const RegisterInfo& reg) {
+  return (reg.type == REG_U32 || reg.type == REG_S32) ? 2 : 1;
+}
+
+// number of decimal places of the scale (0.01 -> 2), -1 if the scale is not a power of ten <= 1
+constexpr int registerDecimals(const RegisterInfo& reg) {
+  double power = 1.0;
+  for (int decimals = 0; decimals <= 6; ++decimals) {
+    const double scaled = reg.scale * power;
+    if (scaled > 0.99999 && scaled < 1.00001)
+      return decimals;
+    power *= 10.0;
+  }
+  return -1;
+}
+
+constexpr RegisterInfo mpptReadRegisters[] = {
+    // 🔋 Battery status
+    {0x3108, "Battery Voltage (V)", 0.01f, REG_U16},
+    {0x3109, "Battery Output Current (A)", 0.01f, REG_U16},
+    {0x310A, "Battery Output Power (W)", 0.01f, REG_U32},
+    {0x311A, "Battery SOC (%)", 1.0f, REG_U16},
+    {0x331B, "Battery Current (A)", 0.01f, REG_S32},
+
+    // ⚡ Load
+    {0x310C, "Load Output Voltage (V)", 0.01f, REG_U16},
+    {0x310D, "Load Output Current (A)", 0.01f, REG_U16},
+    {0x310E, "Load Output Power (W)", 0.01f, REG_U32},
+
+    // ☀️ PV input
+    {0x3100, "PV Input Voltage (V)", 0.01f, REG_U16},
+    {0x3101, "PV Input Current (A)", 0.01f, REG_U16},
+    {0x3102, "PV Input Power (W)", 0.01f, REG_U32},
+
+    // 🌡️ Temps
+    {0x3110, "Remote Battery Temperature (°C)", 0.01f, REG_S16},
+    {0x3111, "Equipment Temperature (°C)", 0.01f, REG_S16},
+    {0x3112, "MOSFET Temperature (°C)", 0.01f, REG_S16},
+
+    // 📊 PV & Battery voltage min/max
+    {0x3300, "Max PV Volt Today (V)", 0.01f, REG_U16},
+    {0x3301, "Min PV Volt Today (V)", 0.01f, REG_U16},
+    {0x3302, "Max Battery Volt Today (V)", 0.01f, REG_U16},
+    {0x3303, "Min Battery Volt Today (V)", 0.01f, REG_U16},
+
+    // 📈 Consume stats
+    {0x3304, "Consumed Energy Today (kWh)", 0.01f, REG_U32},
+    {0x3306, "Consumed Energy This Month (kWh)", 0.01f, REG_U32},
+    {0x3308, "Consumed Energy This Year (kWh)", 0.01f, REG_U32},
+    {0x330A, "Total Consumed Energy (kWh)", 0.01f, REG_U32},
+
+    // 📈 Generate stats
+    {0x330C, "Generated Energy Today (kWh)", 0.01f, REG_U32},
+    {0x330E, "Generated Energy This Month (kWh)", 0.01f, REG_U32},
+    {0x3310, "Generated Energy This Year (kWh)", 0.01f, REG_U32},
+    {0x3312, "Total Generated Energy (kWh)", 0.01f, REG_U32},
+
+    // ⚠️ State registers (flag values)
+    {0x3200, "Battery Status (flags)", 1.0f, REG_U16},
+    {0x3201, "Equipment Charging Status (flags)", 1.0f, REG_U16},
+    {0x3202, "Equipment Discharging Status (flags)", 1.0f, REG_U16},
+};
+
+constexpr size_t mpptReadRegistersCount = std::size(mpptReadRegisters);
+
+constexpr int registerIndex(uint16_t address) {
+  for (size_t i = 0; i < mpptReadRegistersCount; ++i) {
+    if (mpptReadRegisters[i].address == address)
+      return static_cast<int>(i);
+  }
+  return -1;
+}
+
+constexpr int REG_IDX_BATTERY_SOC  = registerIndex(0x311A);
+constexpr int REG_IDX_BATTERY_TEMP = registerIndex(0x3110);
+static_assert(REG_IDX_BATTERY_SOC >= 0 && REG_IDX_BATTERY_TEMP >= 0, "battery registers missing in mpptReadRegisters");
+
+// registers that follow the load output: the load itself, the battery discharge and the discharging status
+constexpr uint16_t mpptLoadRegisterAddresses[] = {0x3109, 0x310A, 0x310C, 0x310D, 0x310E, 0x331B, 0x3202};
+
+constexpr uint64_t loadRegisterMask() {
+  uint64_t mask = 0;
+  for (const uint16_t address : mpptLoadRegisterAddresses) {
+    if (registerIndex(address) < 0)
+      return 0;
+    mask |= 1ULL << registerIndex(address);
+  }
+  return mask;
+}
+
+constexpr uint64_t LOAD_REGISTER_MASK = loadRegisterMask();
+static_assert(LOAD_REGISTER_MASK != 0, "load registers missing in mpptReadRegisters");
+
+constexpr bool allScalesArePowersOfTen() {
+  for (const auto& reg : mpptReadRegisters) {
+    if (registerDecimals(reg) < 0)
+      return false;
+  }
+  return true;
+}
+static_assert(allScalesArePowersOfTen(), "register scales must be 1, 0.1, 0.01, ... to be printed as fixed point");
+
+// JSON object key of a register including quotes and colon, e.g. "0x3108":
+struct RegisterJsonKey {
+  static constexpr size_t LENGTH = 9;
+  char                    text[LENGTH + 1];
+};
+
+constexpr RegisterJsonKey registerJsonKey(uint16_t address) {
+  constexpr char HEX_DIGITS[] = "0123456789ABCDEF";
+  return {{'"', '0', 'x', HEX_DIGITS[address >> 12 & 0xF], HEX_DIGITS[address >> 8 & 0xF],
+           HEX_DIGITS[address >> 4 & 0xF], HEX_DIGITS[address & 0xF], '"', ':', '\0'}};
+}
+
+template <size_t... I>
+constexpr std::array<RegisterJsonKey, sizeof...(I)> makeRegisterJsonKeys(std::index_sequence<I...>) {
+  return {registerJsonKey(mpptReadRegisters[I].address)...};
+}
+
+// indexed like mpptReadRegisters
+constexpr auto mpptRegisterJsonKeys = makeRegisterJsonKeys(std::make_index_sequence<mpptReadRegistersCount>{});
+static_assert(registerJsonKey(0x311A).text[6] == 'A', "register keys use upper case hex digits");
+
+constexpr uint16_t MODBUS_MAX_READ_WORDS = 64;  // ModbusMaster response buffer size
+constexpr uint16_t MODBUS_MAX_GAP_WORDS  = 8;   // unused registers we accept reading to merge two windows
+
+constexpr auto mpptReadPlan = makeReadPlan<MODBUS_MAX_READ_WORDS, MODBUS_MAX_GAP_WORDS>(mpptReadRegisters);
+static_assert(!mpptReadPlan.overlapping, "mpptReadRegisters contains overlapping or duplicate addresses");
+static_assert(!mpptReadPlan.oversized, "register wider than MODBUS_MAX_READ_WORDS");
+
+/**
+ * One raw value per entry of mpptReadRegisters, stored at the register's table index, plus a bitmask of the values
+ * that were actually read. Values keep the controller's integer representation (16-bit registers in the low word,
+ * signed ones as two's complement), scaling happens only when they are printed or compared.
+ */
+struct RegisterValues {
+  static_assert(mpptReadRegistersCount <= 64, "validity mask holds 64 registers");
+
+  std::array<uint32_t, mpptReadRegistersCount> raw{};
+  uint64_t                                     validMask = 0;
+
+  [[nodiscard]] bool isValid(size_t index) const { return validMask & (1ULL << index); }
+  void               set(size_t index, uint32_t rawValue) {
+    raw[index] = rawValue;
+    validMask |= 1ULL << index;
+  }
+  void               invalidate(uint64_t mask) { validMask &= ~mask; }  // bit i stands for mpptReadRegisters[i]
+};
+
+int64_t signedRegisterValue(const RegisterInfo& reg, uint32_t raw);
+float   scaledRegisterValue(const RegisterInfo& reg, uint32_t raw);
+size_t  formatRegisterValue(const RegisterInfo& reg, uint32_t raw, char* out, size_t size);
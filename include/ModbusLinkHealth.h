@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Decides how to recover from a failed RS485 transaction instead of resetting the UART on every error.
+ *
+ * - A Modbus exception means the controller answered: the link is fine, retrying the same request will not help.
+ * - CRC / framing errors are line noise: retry right away, reset the UART only if they keep coming.
+ * - Timeouts first back off the response timeout, then reset the UART.
+ * - A request (start address and register count) that keeps failing while other requests succeed is given up without
+ *   touching the link.
+ * - After LINK_BREAKER_THRESHOLD consecutive failed attempts the controller is considered absent and the breaker
+ *   stays open for the rest of the wake, so no further bus time is spent.
+ */
+enum class LinkAction : uint8_t { Retry, ExtendTimeout, ResetUart, GiveUp };
+
+struct LinkErrorCounters {
+  uint16_t transactions = 0;  // attempts put on the bus
+  uint16_t timeouts     = 0;
+  uint16_t crcErrors    = 0;  // includes invalid slave id / function, i.e. corrupted frames
+  uint16_t exceptions   = 0;  // Modbus exception responses
+  uint16_t uartResets   = 0;
+  uint16_t skipped      = 0;  // requests refused while the breaker was open
+  bool     breakerOpen  = false;
+};
+
+class ModbusLinkHealth {
+ public:
+  static constexpr uint8_t LINK_BREAKER_THRESHOLD    = 6;
+  static constexpr uint8_t LINK_RESET_THRESHOLD      = 3;
+  static constexpr uint8_t REGISTER_GIVE_UP_FAILURES = 2;
+
+  void       recordAttempt() { ++counters_.transactions; }
+  void       recordSuccess(uint16_t address, uint16_t count);
+  LinkAction recordFailure(uint16_t address, uint16_t count, uint8_t result);
+  void       recordReset() { ++counters_.uartResets; }
+  bool       allowRequest();
+
+  [[nodiscard]] const LinkErrorCounters& counters() const { return counters_; }
+
+ private:
+  static constexpr uint8_t TRACKED_REGISTERS = 8;
+
+  // failures of one request, keyed by start address and register count: the same start is also read as a window
+  // and on its own, and only the request that failed is given up
+  struct RegisterFailures {
+    uint16_t address  = 0;
+    uint16_t count    = 0;
+    uint8_t  failures = 0;
+  };
+
+  RegisterFailures* findFailures(uint16_t address, uint16_t count);
+  uint8_t&          registerFailures(uint16_t address, uint16_t count);
+
+  LinkErrorCounters counters_;
+  uint8_t           consecutiveFailures_ = 0;
+  uint8_t           consecutiveTimeouts_ = 0;
+  uint8_t           consecutiveCorrupt_  = 0;
+  uint16_t          successes_           = 0;
+  RegisterFailures  registers_[TRACKED_REGISTERS];
+  uint8_t           nextRegisterSlot_ = 0;
+};
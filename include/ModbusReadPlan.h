@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Compile-time Modbus read schedule.
+ *
+ * A register table is sorted by address and merged into read windows: a register joins the previous window when the
+ * gap to it is at most MaxGap words and the window stays within MaxWords. Every register gets a (window, offset) slot
+ * pointing into the response of its window. The table type only needs an `address` member and a constexpr
+ * `registerWords(reg)` overload found by ADL.
+ */
+struct ReadWindow {
+  uint16_t start;
+  uint16_t count;
+};
+
+struct ReadSlot {
+  uint8_t window;
+  uint8_t offset;
+};
+
+template <size_t N>
+struct ReadPlan {
+  std::array<uint8_t, N>    order{};    // table indices sorted by address
+  std::array<ReadSlot, N>   slots{};    // indexed like the register table
+  std::array<ReadWindow, N> windows{};  // first windowCount entries are used
+  size_t                    windowCount = 0;
+  bool                      overlapping = false;  // two registers share an address
+  bool                      oversized   = false;  // a single register does not fit into one request
+};
+
+template <uint16_t MaxWords, uint16_t MaxGap, typename Reg, size_t N>
+constexpr ReadPlan<N> makeReadPlan(const Reg (&regs)[N]) {
+  static_assert(N <= UINT8_MAX, "register table too large for uint8_t indices");
+  ReadPlan<N> plan{};
+
+  // insertion sort, N is small and std::sort is not constexpr in C++17
+  for (size_t i = 0; i < N; ++i) {
+    plan.order[i] = static_cast<uint8_t>(i);
+    for (size_t j = i; j > 0 && regs[plan.order[j - 1]].address > regs[plan.order[j]].address; --j) {
+      const uint8_t tmp = plan.order[j - 1];
+      plan.order[j - 1] = plan.order[j];
+      plan.order[j]     = tmp;
+    }
+  }
+
+  uint32_t previousEnd = 0;  // exclusive end address of the previous register
+  for (size_t i = 0; i < N; ++i) {
+    const Reg&     reg   = regs[plan.order[i]];
+    const uint16_t words = registerWords(reg);
+    if (words > MaxWords)
+      plan.oversized = true;
+    if (i > 0 && reg.address < previousEnd)
+      plan.overlapping = true;
+    previousEnd = reg.address + words;
+
+    if (plan.windowCount > 0) {
+      ReadWindow&    window    = plan.windows[plan.windowCount - 1];
+      const uint32_t windowEnd = window.start + window.count;
+      if (reg.address <= windowEnd + MaxGap && previousEnd - window.start <= MaxWords) {
+        window.count               = static_cast<uint16_t>(previousEnd - window.start);
+        plan.slots[plan.order[i]] = {static_cast<uint8_t>(plan.windowCount - 1),
+                                     static_cast<uint8_t>(reg.address - window.start)};
+        continue;
+      }
+    }
+
+    plan.windows[plan.windowCount] = {reg.address, words};
+    plan.slots[plan.order[i]]      = {static_cast<uint8_t>(plan.windowCount), 0};
+    ++plan.windowCount;
+  }
+  return plan;
+}
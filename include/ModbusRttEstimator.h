@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+struct RttState {
+  uint32_t srttUs;
+  uint32_t rttvarUs;
+  uint32_t samples;
+};
+
+/**
+ * Per function code response time estimate, kept in RTC memory across deep sleep.
+ *
+ * Follows the TCP retransmission timer (RFC 6298): a smoothed round-trip time and its mean deviation are updated from
+ * every successful transaction and the timeout is SRTT + 4 * RTTVAR, clamped to [MIN_TIMEOUT_US, MAX_TIMEOUT_US].
+ * The round trip is measured from the end of our request to the first response byte, the time the response itself
+ * needs on the wire is added by the caller.
+ */
+class ModbusRttEstimator {
+ public:
+  static constexpr uint32_t MIN_TIMEOUT_US       = 20000;
+  static constexpr uint32_t MAX_TIMEOUT_US       = 2000000;
+  static constexpr uint32_t DEFAULT_TIMEOUT_US   = 300000;  // until the first sample for a function code arrives
+  static constexpr uint32_t CLOCK_GRANULARITY_US = 1000;
+
+  [[nodiscard]] uint32_t timeoutUs(uint8_t function) const;
+  void                   addSample(uint8_t function, uint32_t rttUs);
+  [[nodiscard]] uint32_t smoothedRttUs(uint8_t function) const;
+
+ private:
+  static RttState* stateFor(uint8_t function);
+};
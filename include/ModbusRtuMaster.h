@@ -0,0 +1,66 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "ModbusRttEstimator.h"
+
+/**
+ * Minimal Modbus RTU master for the MPPT link.
+ *
+ * Mirrors the subset of the ModbusMaster API the firmware uses (same method names and result codes), but the response
+ * timeout is a per-transaction setting instead of a compile-time constant. With an RTT estimator attached, the timeout
+ * of every transaction is derived from the measured turnaround of its function code plus the wire time of the expected
+ * response.
+ */
+class ModbusRtuMaster {
+ public:
+  static constexpr uint8_t ku8MBSuccess            = 0x00;
+  static constexpr uint8_t ku8MBIllegalFunction    = 0x01;
+  static constexpr uint8_t ku8MBIllegalDataAddress = 0x02;
+  static constexpr uint8_t ku8MBIllegalDataValue   = 0x03;
+  static constexpr uint8_t ku8MBSlaveDeviceFailure = 0x04;
+  static constexpr uint8_t ku8MBInvalidSlaveID     = 0xE0;
+  static constexpr uint8_t ku8MBInvalidFunction    = 0xE1;
+  static constexpr uint8_t ku8MBResponseTimedOut   = 0xE2;
+  static constexpr uint8_t ku8MBInvalidCRC         = 0xE3;
+
+  static constexpr uint8_t  ku8MaxBufferSize             = 64;  // words
+  static constexpr uint16_t ku16DefaultResponseTimeoutMs = 300;
+  static constexpr uint8_t  ku8MaxTimeoutBackoff         = 4;  // timeout grows at most 2^4 times
+
+  void begin(uint8_t slave, Stream& serial, uint32_t baud);
+  void preTransmission(void (*callback)()) { preTransmission_ = callback; }
+  void postTransmission(void (*callback)()) { postTransmission_ = callback; }
+
+  void                   setResponseTimeout(uint16_t timeoutMs) { responseTimeoutMs_ = timeoutMs; }
+  void                   setRttEstimator(ModbusRttEstimator* estimator) { rttEstimator_ = estimator; }
+  void                   extendResponseTimeout();
+
+  uint8_t readCoils(uint16_t address, uint16_t quantity);
+  uint8_t readHoldingRegisters(uint16_t address, uint16_t quantity);
+  uint8_t readInputRegisters(uint16_t address, uint16_t quantity);
+  uint8_t writeSingleCoil(uint16_t address, uint8_t state);
+  uint8_t writeSingleRegister(uint16_t address, uint16_t value);
+  uint8_t writeMultipleRegisters(uint16_t address, uint16_t quantity);
+
+  [[nodiscard]] uint16_t getResponseBuffer(uint8_t index) const;
+  void                   clearTransmitBuffer();
+  uint8_t                setTransmitBuffer(uint8_t index, uint16_t value);
+
+ private:
+  uint8_t                transaction(uint8_t function, uint16_t address, uint16_t quantityOrValue);
+  [[nodiscard]] uint32_t responseTimeoutUs(uint8_t function, size_t expectedBytes) const;
+
+  static uint16_t crc16(const uint8_t* data, size_t length);
+
+  Stream*             serial_            = nullptr;
+  ModbusRttEstimator* rttEstimator_      = nullptr;
+  uint8_t             slave_             = 1;
+  uint32_t            charTimeUs_        = 87;  // 10 bits at 115200 baud
+  uint16_t            responseTimeoutMs_ = ku16DefaultResponseTimeoutMs;
+  uint8_t             timeoutBackoff_    = 0;
+  uint16_t responseBuffer_[ku8MaxBufferSize]{};
+  uint16_t transmitBuffer_[ku8MaxBufferSize]{};
+  void (*preTransmission_)()  = nullptr;
+  void (*postTransmission_)() = nullptr;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Globals.h"
+
+enum class ModemStage : uint8_t {
+  PowerOn,  // power / reset / PWRKEY sequence until the modem answers AT, PWRKEY is pulsed again meanwhile
+  Sim,
+  Registration,
+  Pdp,       // APN and data connection
+  Transfer,  // each HTTP exchange: config download, OTA check, upload
+  Count
+};
+
+constexpr size_t      MODEM_STAGE_COUNT = static_cast<size_t>(ModemStage::Count);
+constexpr const char* MODEM_STAGE_NAMES[MODEM_STAGE_COUNT] = {"power_on", "sim", "registration", "pdp", "transfer"};
+
+/**
+ * Time budget of the modem session of one wake and the retry backoff between sessions.
+ *
+ * start() opens the session budget (MODEM_SESSION_BUDGET_MS). Every stage gets its own deadline, capped by the
+ * session budget, and its loop polls expired(). A stage that runs out gives up and calls fail(), which makes the next
+ * sessions back off: after n failed sessions in a row, isBackingOff() holds for MODEM_RETRY_BACKOFF_SEC * 2^(n-1)
+ * seconds (at most MODEM_RETRY_BACKOFF_MAX_SEC), counted in wakes so it works without a valid clock. succeed() after
+ * a complete upload, or one cut short by the budget after some data got through, clears the failures. The worst-case modem time of a wake is the session budget, below the task
+ * watchdog.
+ *
+ * Only one task uses the session at a time: the modem task until it is joined, loop() after that.
+ */
+class ModemSession {
+ public:
+  static void     begin();  // call once per wake, counts the wakes of a backoff
+  static void     start();
+  static void     beginStage(ModemStage stage);
+  static void     beginStage(ModemStage stage, uint32_t budgetMs);
+  static bool     expired();
+  static uint32_t remainingMs();  // of the current stage, 0 once expired
+  static void     fail();
+  static void     succeed();
+
+  [[nodiscard]] static ModemStage stage();
+  [[nodiscard]] static bool       isBackingOff();
+};
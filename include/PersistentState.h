@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Values that outlive a wake cycle.
+ */
+struct PersistentData {
+  uint64_t totalAwakeTime    = 0;           // seconds, across all wake sessions
+  uint32_t lastModemUsedTime = UINT32_MAX;  // epoch of the last modem session, UINT32_MAX: never
+  uint32_t failedLines       = 0;           // entries the last upload could not deliver
+  int64_t  nextLoadOn        = 0;
+  int64_t  nextLoadOff       = 0;
+  uint8_t  uploadFormat      = UINT8_MAX;  // UploadFormat the config chose, UINT8_MAX: MPPT_UPLOAD_FORMAT
+};
+
+/**
+ * Single copy of the PersistentData in RTC memory, so a wake cycle neither opens Preferences nor reads NVS.
+ *
+ * load() trusts the RTC copy when its checksum matches and reads NVS only on a cold boot (or after the RTC copy was
+ * lost or left inconsistent by a reset mid-wake). Changes go to data() and reach NVS in flush(), called right before
+ * deep sleep, which writes only the keys that differ from what NVS holds.
+ */
+class PersistentState {
+ public:
+  static void            load();
+  static PersistentData& data() { return block_.data; }
+  static void            flush();
+
+ private:
+  static constexpr uint32_t MAGIC = 0x50535431;  // "PST1"
+
+  struct Block {
+    uint32_t       magic;
+    uint32_t       crc;  // over data and stored
+    PersistentData data;
+    PersistentData stored;  // what NVS holds
+  };
+
+  static uint32_t checksum();
+
+  static Block block_;
+};
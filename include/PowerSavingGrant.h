@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * LTE power saving timers the network granted, parsed from the modem's reports. The timers are 3GPP TS 24.008 GPRS
+ * timer bytes as the modem prints them, e.g. "00100001": unit in the top three bits, value in the lower five.
+ */
+struct PowerSavingGrant {
+  static constexpr uint8_t NOT_GRANTED = 0xE0;  // unit 111: timer deactivated
+
+  int8_t  registration = -1;           // <stat>, 1 home, 5 roaming
+  uint8_t activeTime   = NOT_GRANTED;  // T3324, GPRS timer 2
+  uint8_t periodicTau  = NOT_GRANTED;  // T3412 extended, GPRS timer 3
+  bool    edrx         = false;
+
+  [[nodiscard]] bool     isRegistered() const { return registration == 1 || registration == 5; }
+  [[nodiscard]] bool     isPsmGranted() const;
+  [[nodiscard]] uint32_t activeTimeSeconds() const;  // 0 when not granted
+  [[nodiscard]] uint32_t periodicTauSeconds() const;
+
+  // parses the AT+CEREG? report with <n>=4 ("+CEREG: 4,1,"5A1E","0B28A40A",7,,,"00000101","00100001"")
+  bool parseRegistration(const char* report);
+  // parses the AT+CEDRXRDP report ("+CEDRXRDP: 4,"0101","0101","0011""), <AcT-type> 0: eDRX not in use
+  bool parseEdrx(const char* report);
+
+  // GPRS timer byte of a bit string like "00100001", NOT_GRANTED if it is malformed
+  static uint8_t parseTimer(const char* bits);
+};
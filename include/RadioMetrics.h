@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+enum class RadioAccess : uint8_t { Unknown, Gsm, Wcdma, Lte };
+
+/**
+ * Radio state of one modem session, captured once after network registration and copied into every LogEntry taken
+ * while the modem is on, so serializing an entry never talks to the modem. Cell identity and the LTE measurements come
+ * from the AT+CPSI? report; fields the modem did not report keep their defaults.
+ */
+struct RadioMetrics {
+  static constexpr int16_t NOT_REPORTED = INT16_MIN;
+
+  uint8_t     csq          = 99;  // AT+CSQ 0..31, 99 unknown
+  int8_t      registration = -1;  // TinyGSM RegStatus, -1 no result
+  RadioAccess access       = RadioAccess::Unknown;
+  uint16_t    mcc          = 0;
+  uint16_t    mnc          = 0;
+  uint16_t    areaCode     = 0;  // LTE TAC, GSM / WCDMA LAC
+  uint32_t    cellId       = 0;
+  int16_t     rsrp         = NOT_REPORTED;  // 0.1 dBm, LTE only
+  int16_t     rsrq         = NOT_REPORTED;  // 0.1 dB, LTE only
+  int16_t     sinr         = NOT_REPORTED;  // dB (RSSNR), LTE only
+
+  [[nodiscard]] int signalPercentage() const { return csq > 31 ? -1 : csq * 100 / 31; }
+
+  // parses the AT+CPSI? report ("LTE,Online,231-01,0x5A1E,187214346,75,EUTRAN-BAND3,1300,5,5,-131,-1010,-781,7")
+  bool parseSystemInformation(const char* info);
+};
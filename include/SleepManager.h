@@ -16,6 +16,8 @@ class SleepManager {
   uint64_t getTotalWakeTime() const;
 
  private:
+  void prepareForSleep();
+
   uint64_t totalAwakeTime  = 0;  // total across all sessions (seconds)
   uint32_t wakeStartMillis = 0;  // millis at wake start
 };
@@ -1,14 +1,17 @@
 #pragma once
 
 #include "LoggingService.h"
-
-enum RegType { REG_U16, REG_U32, REG_S16, REG_S32 };
-
-struct RegisterInfo {
-  uint16_t    address;
-  const char* name;
-  float       scale;
-  RegType     type;
+#include "MPPTRegisters.h"
+#include "ModbusLinkHealth.h"
+
+/**
+ * Register values read during the current wake. Every value is read at most once per wake unless it is invalidated,
+ * so the load decision, the battery checks and the logged entry all see the same data.
+ */
+struct RegisterSnapshot {
+  RegisterValues registers;
+  int            loadState      = -1;
+  bool           loadStateValid = false;
 };
 
 struct HoldingRegisterInfo {
@@ -16,56 +19,6 @@ struct HoldingRegisterInfo {
   const char* name;
 };
 
-inline RegisterInfo regBatterySoc  = {0x311A, "Battery SOC (%)", 1.0f, REG_U16};
-inline RegisterInfo regBatteryTemp = {0x3110, "Battery Temp (°C)", 0.01f, REG_U16};
-
-constexpr RegisterInfo mpptReadRegisters[] = {
-    // 🔋 Battery status
-    {0x3108, "Battery Voltage (V)", 0.01f, REG_U16},
-    {0x3109, "Battery Output Current (A)", 0.01f, REG_U16},
-    {0x310A, "Battery Output Power (W)", 0.01f, REG_U32},
-    {0x311A, "Battery SOC (%)", 1.0f, REG_U16},
-    {0x331B, "Battery Current (A)", 0.01f, REG_S32},
-
-    // ⚡ Load
-    {0x310C, "Load Output Voltage (V)", 0.01f, REG_U16},
-    {0x310D, "Load Output Current (A)", 0.01f, REG_U16},
-    {0x310E, "Load Output Power (W)", 0.01f, REG_U32},
-
-    // ☀️ PV input
-    {0x3100, "PV Input Voltage (V)", 0.01f, REG_U16},
-    {0x3101, "PV Input Current (A)", 0.01f, REG_U16},
-    {0x3102, "PV Input Power (W)", 0.01f, REG_U32},
-
-    // 🌡️ Temps
-    {0x3110, "Remote Battery Temperature (°C)", 0.01f, REG_S16},
-    {0x3111, "Equipment Temperature (°C)", 0.01f, REG_S16},
-    {0x3112, "MOSFET Temperature (°C)", 0.01f, REG_S16},
-
-    // 📊 PV & Battery voltage min/max
-    {0x3300, "Max PV Volt Today (V)", 0.01f, REG_U16},
-    {0x3301, "Min PV Volt Today (V)", 0.01f, REG_U16},
-    {0x3302, "Max Battery Volt Today (V)", 0.01f, REG_U16},
-    {0x3303, "Min Battery Volt Today (V)", 0.01f, REG_U16},
-
-    // 📈 Consume stats
-    {0x3304, "Consumed Energy Today (kWh)", 0.01f, REG_U32},
-    {0x3306, "Consumed Energy This Month (kWh)", 0.01f, REG_U32},
-    {0x3308, "Consumed Energy This Year (kWh)", 0.01f, REG_U32},
-    {0x330A, "Total Consumed Energy (kWh)", 0.01f, REG_U32},
-
-    // 📈 Generate stats
-    {0x330C, "Generated Energy Today (kWh)", 0.01f, REG_U32},
-    {0x330E, "Generated Energy This Month (kWh)", 0.01f, REG_U32},
-    {0x3310, "Generated Energy This Year (kWh)", 0.01f, REG_U32},
-    {0x3312, "Total Generated Energy (kWh)", 0.01f, REG_U32},
-
-    // ⚠️ State registers (flag values)
-    {0x3200, "Battery Status (flags)", 1.0f, REG_U16},
-    {0x3201, "Equipment Charging Status (flags)", 1.0f, REG_U16},
-    {0x3202, "Equipment Discharging Status (flags)", 1.0f, REG_U16},
-};
-
 struct DateTimeFields {
   uint8_t second;
   uint8_t minute;
@@ -102,11 +55,24 @@ class SolarMPPTMonitor {
   static bool     readLoadState(int& loadState);
   static bool     setLoad(bool enable);
   static bool     readBatteryStatus(float& socPercent, float& tempC);
+  static bool     pollRegisters();
 
  private:
-  static bool readRegister(const RegisterInfo& reg, float& outValue);
-  static bool readHoldingRegister(uint16_t address, uint16_t& outValue);
-  static bool writeHoldingRegister(uint16_t address, uint16_t value);
+  static bool     readRegister(const RegisterInfo& reg, uint32_t& outValue);
+  static uint8_t  readRegisterBlock(const ReadWindow& window);
+  static bool     readRegisterIntoSnapshot(size_t index);
+  static bool     pollWindowParts(size_t first, size_t last);
+  static uint32_t decodeRegister(const RegisterInfo& reg, uint8_t offset);
+  static bool     readHoldingRegister(uint16_t address, uint16_t& outValue);
+  static bool     writeHoldingRegister(uint16_t address, uint16_t value);
 
   static bool readDatetimeInMPPT(DateTimeFields& dt);
+
+  template <typename Request>
+  static uint8_t runTransaction(uint16_t address, uint16_t count, Request request);
+
+  static RegisterSnapshot   snapshot_;
+  static ModbusLinkHealth   linkHealth_;
+  static ModbusRttEstimator rttEstimator_;
+  static uint64_t           splitWindows_;  // bit w: mpptReadPlan.windows[w] is read in gap-free parts, kept in RTC
 };
@@ -11,6 +11,7 @@ class TimeService {
   static void   setTimeAfterWakeUp();
   static void   debugTime();
   static time_t parseISO8601(const char* isoStr);
+  static bool   isTimeValid();  // the clock has been set at some point, it is not counting from 1970
   static bool   isTimeToUseModem();
   static ulong  getLastModemPreference();
   static void   updateLastModemPreference();
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "BufferPrint.h"
+#include "LoggingService.h"
+#include "UploadFormat.h"
+
+/**
+ * Collects log entries into the body of one upload request. The upload loop adds entries until add() refuses one,
+ * sends finish() and starts over with clear(). Buffers are allocated once per upload session in begin(). The session's
+ * WakeReport goes in first, as an item of its own next to the entries.
+ */
+class UploadEncoder {
+ public:
+  virtual ~UploadEncoder() = default;
+
+  virtual bool                      begin()                    = 0;
+  virtual bool                      add(const LogEntry& entry) = 0;  // false: batch full, entry not added
+  virtual bool                      add(const WakeReport& report) = 0;  // false: not added, or not in this format
+  virtual const uint8_t*            finish(size_t& length)     = 0;
+  virtual void                      clear()                    = 0;
+  [[nodiscard]] virtual size_t      count() const              = 0;
+  [[nodiscard]] virtual const char* contentType() const        = 0;
+  [[nodiscard]] virtual const char* resource() const           = 0;
+};
+
+// text body streamed into one buffer of MPPT_UPLOAD_BATCH_BYTES, up to MPPT_UPLOAD_BATCH_RECORDS entries
+class BufferedUploadEncoder : public UploadEncoder {
+ public:
+  ~BufferedUploadEncoder() override;
+
+  bool                 begin() override;
+  bool                 add(const LogEntry& entry) override;
+  bool                 add(const WakeReport& report) override;
+  void                 clear() override;
+  [[nodiscard]] size_t count() const override { return count_; }
+
+ protected:
+  // writes one item; an item that does not fit (leaving room for finish()) is rolled back by add()
+  virtual void print(const LogEntry& entry)    = 0;
+  virtual void print(const WakeReport& report) = 0;
+
+  BufferPrint body_{nullptr, 0};
+  size_t      count_ = 0;
+
+ private:
+  bool commit(size_t start);
+
+  uint8_t* buffer_ = nullptr;
+};
+
+// JSON array of LogEntry::printJson() objects
+class JsonUploadEncoder final : public BufferedUploadEncoder {
+ public:
+  const uint8_t*            finish(size_t& length) override;
+  [[nodiscard]] const char* contentType() const override { return "application/json"; }
+  [[nodiscard]] const char* resource() const override { return HTTP_TELEGRAF_RESOURCE_MPPT; }
+
+ protected:
+  void print(const LogEntry& entry) override;
+  void print(const WakeReport& report) override;
+};
+
+// InfluxDB line protocol, one LogEntry::printLineProtocol() line per entry
+class LineProtocolUploadEncoder final : public BufferedUploadEncoder {
+ public:
+  const uint8_t*            finish(size_t& length) override;
+  [[nodiscard]] const char* contentType() const override { return "text/plain; charset=utf-8"; }
+  [[nodiscard]] const char* resource() const override { return HTTP_TELEGRAF_RESOURCE_MPPT_LINE; }
+
+ protected:
+  void print(const LogEntry& entry) override { entry.printLineProtocol(body_); }
+  void print(const WakeReport& report) override { report.printLineProtocol(body_); }
+};
+
+// MessagePack array of the LogEntry::toDocument() maps, register values as numbers
+class MsgPackUploadEncoder final : public BufferedUploadEncoder {
+ public:
+  const uint8_t*            finish(size_t& length) override;
+  [[nodiscard]] const char* contentType() const override { return "application/msgpack"; }
+  [[nodiscard]] const char* resource() const override { return HTTP_TELEGRAF_RESOURCE_MPPT_MSGPACK; }
+
+ protected:
+  void print(const LogEntry& entry) override;
+  void print(const WakeReport& report) override;
+
+ private:
+  void printHeader();
+
+  static constexpr uint8_t ARRAY32 = 0xDD;  // array header with a 32-bit big-endian length, patched in finish()
+};
+
+// LogChunkEncoder chunk of up to MPPT_UPLOAD_CHUNK_RECORDS entries, expanded by the backend
+class ChunkUploadEncoder final : public UploadEncoder {
+ public:
+  ~ChunkUploadEncoder() override;
+
+  bool                      begin() override;
+  bool                      add(const LogEntry& entry) override;
+  bool                      add(const WakeReport&) override { return false; }  // the backend expands entries only
+  const uint8_t*            finish(size_t& length) override;
+  void                      clear() override { count_ = 0; }
+  [[nodiscard]] size_t      count() const override { return count_; }
+  [[nodiscard]] const char* contentType() const override { return "application/vnd.esp-mppt.chunk"; }
+  [[nodiscard]] const char* resource() const override { return HTTP_TELEGRAF_RESOURCE_MPPT_CHUNK; }
+
+ private:
+  LogEntry* entries_ = nullptr;
+  uint8_t*  chunk_   = nullptr;
+  size_t    count_   = 0;
+};
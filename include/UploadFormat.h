@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+enum class UploadFormat : uint8_t { Json, LineProtocol, MsgPack, Chunk, Count };
+
+constexpr size_t      UPLOAD_FORMAT_COUNT = static_cast<size_t>(UploadFormat::Count);
+constexpr const char* UPLOAD_FORMAT_NAMES[UPLOAD_FORMAT_COUNT] = {"json", "line", "msgpack", "chunk"};
+
+// format named `name` in the config ("json", "line", "msgpack", "chunk"), false if there is none of that name
+inline bool parseUploadFormat(const char* name, UploadFormat& format) {
+  for (size_t i = 0; name != nullptr && i < UPLOAD_FORMAT_COUNT; ++i) {
+    if (strcmp(name, UPLOAD_FORMAT_NAMES[i]) == 0) {
+      format = static_cast<UploadFormat>(i);
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <esp_timer.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Globals.h"
+
+enum class WakePhase : uint8_t {
+  WakeSetup,
+  StoreOpen,  // LittleFS mount and log state, nested in whichever phase first needs the log
+  LoadSetup,
+  ModemSetup,  // runs in the modem task, next to the Modbus poll and log append
+  ModemWait,   // loop() waiting for the rest of the modem setup
+  ConfigDownload,
+  OtaUpdate,
+  ModbusPoll,  // every Modbus transaction of the wake: the register poll, load control and RTC sync
+  LogAppend,
+  Upload,
+  SleepEntry,
+  Awake,  // whole wake, from app start to deep sleep
+  Count
+};
+
+constexpr size_t      WAKE_PHASE_COUNT = static_cast<size_t>(WakePhase::Count);
+constexpr const char* WAKE_PHASE_NAMES[WAKE_PHASE_COUNT] = {
+    "wake_setup", "store_open", "load_setup", "modem_setup", "modem_wait", "config",
+    "ota",        "modbus",     "log_append", "upload",      "sleep_entry", "awake"};  // at most 12 characters
+
+/**
+ * Compact wake profile sent with the WakeReport of an upload, all durations in milliseconds (saturating at 65535).
+ *
+ * `lastMs` holds the phases of the last finished wake, 0 for phases that did not run, and min / mean / max the
+ * statistics of every phase over the last MPPT_WAKE_PROFILE_WINDOW wakes (over the wakes it ran in).
+ */
+struct WakeProfile {
+  // upper bound of the printed profile, the line protocol fields being the longest form
+  static constexpr size_t MAX_PRINT_LENGTH = 32 + WAKE_PHASE_COUNT * 128;
+
+  uint16_t lastMs[WAKE_PHASE_COUNT];
+  uint16_t minMs[WAKE_PHASE_COUNT];
+  uint16_t meanMs[WAKE_PHASE_COUNT];
+  uint16_t maxMs[WAKE_PHASE_COUNT];
+  uint16_t windowWakes;
+};
+
+/**
+ * Per-phase timing of the wake cycle with the microsecond esp_timer. Only called from loop()'s task; the modem task
+ * hands its setup time over when it is joined.
+ *
+ * Phases are timed by a ScopedPhase (PROFILE_PHASE) and summed per wake. finishWake() folds the wake into a window of
+ * per-phase min / total / max kept in RTC memory; a full window becomes the reported one and a new window starts. With
+ * MPPT_WAKE_PROFILE false, PROFILE_PHASE expands to nothing and uploads carry no WakeReport.
+ */
+class WakeProfiler {
+ public:
+  static void        begin();  // call first thing after boot
+  static void        record(WakePhase phase, uint32_t durationUs);
+  static void        finishWake();  // call right before deep sleep
+  static WakeProfile profile();
+
+  static const uint32_t (&lastWakeUs())[WAKE_PHASE_COUNT];  // phases of the last finished wake, 0: did not run
+};
+
+class ScopedPhase {
+ public:
+  explicit ScopedPhase(const WakePhase phase) : phase_(phase), startUs_(esp_timer_get_time()) {}
+  ~ScopedPhase() { WakeProfiler::record(phase_, static_cast<uint32_t>(esp_timer_get_time() - startUs_)); }
+  ScopedPhase(const ScopedPhase&)            = delete;
+  ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+ private:
+  WakePhase phase_;
+  int64_t   startUs_;
+};
+
+#if MPPT_WAKE_PROFILE
+#define PROFILE_PHASE(phase) const ScopedPhase profiledPhase(phase)
+#else
+#define PROFILE_PHASE(phase)
+#endif
@@ -4,19 +4,64 @@
 #include <HardwareSerial.h>
 #include <Wire.h>
 #include <base64.h>
+#include <driver/gpio.h>
+#include <esp_attr.h>
 #include <esp_task_wdt.h>
 
 #include "Globals.h"
 #include "LoadController.h"
+#include "LoggingService.h"
+#include "ModemSession.h"
+#include "PersistentState.h"
 #include "SolarMPPTMonitor.h"
 #include "TimeService.h"
+#include "WakeProfiler.h"
 #include "secrets.h"
 #include <Update.h>
 
-void CommunicationA7670E::setupModemImpl() {
+RTC_DATA_ATTR bool CommunicationA7670E::asleep_ = false;
+
+namespace {
+struct HeldPin {
+  gpio_num_t pin;
+  uint8_t    level;
+};
+
+// driven while the modem sleeps attached, held at these levels through the ESP32 deep sleep
+constexpr HeldPin DTR_HOLD     = {static_cast<gpio_num_t>(MODEM_DTR_PIN), HIGH};
+constexpr HeldPin SLEEP_PINS[] = {{static_cast<gpio_num_t>(BOARD_POWERON_PIN), HIGH},
+                                  {static_cast<gpio_num_t>(MODEM_RESET_PIN), !MODEM_RESET_LEVEL},
+                                  {static_cast<gpio_num_t>(BOARD_PWRKEY_PIN), LOW},
+                                  DTR_HOLD};
+
+// a released pin falls back to a floating input, so it is driven at its held level first
+void releaseHold(const HeldPin& held) {
+  pinMode(held.pin, OUTPUT);
+  digitalWrite(held.pin, held.level);
+  gpio_hold_dis(held.pin);
+}
+}  // namespace
+
+bool CommunicationA7670E::setupModemImpl() {
+  psmGranted_ = false;
   SerialAT.begin(115200, SERIAL_8N1, MODEM_RX_PIN, MODEM_TX_PIN);
   DBG_PRINTLN(F("[ComA7670E] SerialAT started"));
 
+#if MODEM_POWER_SAVING
+  if (asleep_) {
+    asleep_ = false;
+    // the wake only re-drives DTR, the supply enable, reset and PWRKEY stay held
+    releaseHold(DTR_HOLD);
+    if (wakeFromSleep())
+      return true;
+    DBG_PRINTLN(F("[ComA7670E] Modem not attached after sleep, powering it on"));
+  }
+#endif
+  for (const HeldPin& held : SLEEP_PINS)
+    releaseHold(held);
+
+  ModemSession::beginStage(ModemStage::PowerOn);
+
 #ifdef BOARD_POWERON_PIN
   pinMode(BOARD_POWERON_PIN, OUTPUT);
   digitalWrite(BOARD_POWERON_PIN, HIGH);
@@ -49,6 +94,10 @@ void CommunicationA7670E::setupModemImpl() {
   int retry = 0;
   while (!modem.testAT(1000)) {
     DBG_PRINT(".");
+    if (ModemSession::expired()) {
+      DBG_PRINTLN(F("\n[ComA7670E] Modem does not answer, giving up"));
+      return false;
+    }
     if (retry++ > 10) {
       digitalWrite(BOARD_PWRKEY_PIN, LOW);
       delay(100);
@@ -61,6 +110,7 @@ void CommunicationA7670E::setupModemImpl() {
   }
   DBG_PRINTLN("");
 
+  ModemSession::beginStage(ModemStage::Sim);
   SimStatus sim = SIM_ERROR;
   while (sim != SIM_READY) {
     sim = modem.getSimStatus();
@@ -76,6 +126,10 @@ void CommunicationA7670E::setupModemImpl() {
         DBG_PRINTLN(F("[ComA7670E] Waiting for SIM..."));
         break;
     }
+    if (sim != SIM_READY && ModemSession::expired()) {
+      DBG_PRINTLN(F("[ComA7670E] SIM not ready, giving up"));
+      return false;
+    }
     delay(100);
   }
 
@@ -84,11 +138,20 @@ void CommunicationA7670E::setupModemImpl() {
   if (modem.waitResponse() != 1) {
     DBG_PRINTLN("[ComA7670E] Set network apn error !");
   }
+#if MODEM_POWER_SAVING
+  requestPowerSaving();  // before registration, so the attach already negotiates the timers
+#endif
 
   int16_t sq;
   DBG_PRINT(F("[ComA7670E] Waiting for network registration"));
+  ModemSession::beginStage(ModemStage::Registration);
   RegStatus status = REG_NO_RESULT;
   while (status == REG_NO_RESULT || status == REG_SEARCHING || status == REG_UNREGISTERED) {
+    if (ModemSession::expired()) {
+      DBG_PRINTLN(F("[ComA7670E] Network registration timed out"));
+      captureRadioMetrics(status);
+      return false;
+    }
     status = modem.getRegistrationStatus();
     switch (status) {
       case REG_UNREGISTERED:
@@ -99,7 +162,8 @@ void CommunicationA7670E::setupModemImpl() {
         break;
       case REG_DENIED:
         DBG_PRINTLN(F("[ComA7670E] Network registration denied, check APN"));
-        return;
+        captureRadioMetrics(status);
+        return false;
       case REG_OK_HOME:
         DBG_PRINTLN(F("[ComA7670E] Online registration successful"));
         break;
@@ -114,99 +178,218 @@ void CommunicationA7670E::setupModemImpl() {
   }
 
   DBG_PRINTF("[ComA7670E] Final registration status: %d\n", status);
+  captureRadioMetrics(status);
 
-  String ueInfo;
-  if (modem.getSystemInformation(ueInfo)) {
-    DBG_PRINT(F("[ComA7670E] UE System Info: "));
-    DBG_PRINTLN(ueInfo);
-  }
-
-  if (!modem.setNetworkActive()) {
+  ModemSession::beginStage(ModemStage::Pdp);
+  while (!modem.setNetworkActive()) {
     DBG_PRINTLN(F("[ComA7670E] Enable network failed!"));
-  } else {
-    DBG_PRINTLN(F("[ComA7670E] Network activated"));
+    if (ModemSession::expired())
+      return false;
+    delay(1000);
   }
+  DBG_PRINTLN(F("[ComA7670E] Network activated"));
 
   String ipAddress = modem.getLocalIP();
   DBG_PRINT("[ComA7670E] Network IP:"); DBG_PRINTLN(ipAddress);
+#if MODEM_POWER_SAVING
+  psmGranted_ = readPowerSavingGrant().isPsmGranted();
+#endif
+  return true;
+}
+
+bool CommunicationA7670E::wakeFromSleep() {
+  ModemSession::beginStage(ModemStage::PowerOn, MODEM_DEADLINE_WAKE_MS);
+  digitalWrite(MODEM_DTR_PIN, LOW);
+  while (!modem.testAT(500)) {
+    if (ModemSession::expired())
+      return false;
+  }
+  modem.sendAT(GF("+CSCLK=0"));
+  modem.waitResponse();
+
+  ModemSession::beginStage(ModemStage::Registration);
+  const PowerSavingGrant grant = readPowerSavingGrant();
+  if (!grant.isRegistered())
+    return false;
+  captureRadioMetrics(static_cast<RegStatus>(grant.registration));
+
+  ModemSession::beginStage(ModemStage::Pdp);
+  if (!modem.isGprsConnected() && !modem.setNetworkActive()) {
+    DBG_PRINTLN(F("[ComA7670E] Enable network failed after sleep"));
+    return false;
+  }
+  psmGranted_ = grant.isPsmGranted();
+  DBG_PRINTLN(F("[ComA7670E] Modem woken, still attached"));
+  return true;
 }
 
-void CommunicationA7670E::sendMPPTPayload() {
+void CommunicationA7670E::requestPowerSaving() {
+  modem.sendAT(GF("+CPSMS=1,,,\""), MODEM_PSM_PERIODIC_TAU, GF("\",\""), MODEM_PSM_ACTIVE_TIME, GF("\""));
+  if (modem.waitResponse() != 1)
+    DBG_PRINTLN(F("[ComA7670E] PSM request refused by the modem"));
+  modem.sendAT(GF("+CEDRXS=1,4,\""), MODEM_EDRX_CYCLE, GF("\""));
+  if (modem.waitResponse() != 1)
+    DBG_PRINTLN(F("[ComA7670E] eDRX request refused by the modem"));
+  // report the granted timers with the registration state
+  modem.sendAT(GF("+CEREG=4"));
+  modem.waitResponse();
+}
+
+PowerSavingGrant CommunicationA7670E::readPowerSavingGrant() {
+  PowerSavingGrant grant;
+  modem.sendAT(GF("+CEREG?"));
+  if (modem.waitResponse(1000L, GF("+CEREG:")) == 1) {
+    grant.parseRegistration(modem.stream.readStringUntil('\n').c_str());
+    modem.waitResponse();
+  }
+  modem.sendAT(GF("+CEDRXRDP"));
+  if (modem.waitResponse(1000L, GF("+CEDRXRDP:")) == 1) {
+    grant.parseEdrx(modem.stream.readStringUntil('\n').c_str());
+    modem.waitResponse();
+  }
+  DBG_PRINTF("[ComA7670E] Registration %d, PSM %s (active %u s, TAU %u s), eDRX %s\n", grant.registration,
+             grant.isPsmGranted() ? "granted" : "rejected", grant.activeTimeSeconds(), grant.periodicTauSeconds(),
+             grant.edrx ? "granted" : "rejected");
+  return grant;
+}
+
+void CommunicationA7670E::sendMPPTPayload(const UploadFormat format) {
+  PROFILE_PHASE(WakePhase::Upload);
   if (!isModemOn()) {
     DBG_PRINTLN("[ComA7670E] Modem is offline.");
     return;
   }
 
-  File   original       = LittleFS.open(MPPT_LOG_FILE_NAME, FILE_READ);
-  String TEMP_FILE_NAME = String(MPPT_LOG_FILE_NAME) + ".tmp";
-  if (!original) {
-    DBG_PRINTLN("[ComA7670E]  File not found");
-    return;
+  // one upload session: the TCP connection is reused across batches, HttpClient reconnects only if the server closed it
+  const String authorization = "Basic " + base64::encode(String(TELEGRAM_HTTP_USER) + ":" + TELEGRAM_HTTP_PASS);
+  clientTelegraf.connectionKeepAlive();
+  GzipEncoder gzip(MPPT_UPLOAD_BATCH_BYTES);
+  const bool  compress = MPPT_UPLOAD_GZIP && gzip.begin();
+
+  JsonUploadEncoder         jsonEncoder;
+  LineProtocolUploadEncoder lineEncoder;
+  MsgPackUploadEncoder      msgPackEncoder;
+  ChunkUploadEncoder        chunkEncoder;
+  UploadEncoder*            encoder = &jsonEncoder;
+  if (format == UploadFormat::Chunk) {
+    if (chunkEncoder.begin())
+      encoder = &chunkEncoder;
+    else
+      DBG_PRINTLN("[ComA7670E] No memory for chunk upload, sending JSON");
+  } else if (format == UploadFormat::LineProtocol) {
+    encoder = &lineEncoder;
+  } else if (format == UploadFormat::MsgPack) {
+    encoder = &msgPackEncoder;
   }
-
-  File tempFile = LittleFS.open(TEMP_FILE_NAME.c_str(), "w");
-  if (!tempFile) {
-    DBG_PRINTLN("[ComA7670E]  Could not create temp file");
-    original.close();
+  if (encoder != &chunkEncoder && !encoder->begin()) {
+    DBG_PRINTLN("[ComA7670E] No memory for the upload buffer!");
     return;
   }
-
-  if (clientTelegraf.connected())
-    DBG_PRINTF("[ComA7670E] HTTP Client Connected to %s:%d\n", HTTP_TELEGRAF_SERVER, HTTP_TELEGRAF_PORT);
-
-  size_t failedLines = 0;
-  while (original.available()) {
-    String line = original.readStringUntil('\n');
-    line.trim();
-    if (line.length() == 0)
+  DBG_PRINTF("[ComA7670E] Uploading as %s\n", encoder->contentType());
+  const WakeReport report = WakeReport::capture();
+  if (!report.isEmpty() && !encoder->add(report))
+    DBG_PRINTLN("[ComA7670E] Upload format carries no wake report");
+
+  // Entries are sent from the acknowledged cursor on, in batches as large as the encoder takes. The cursor advances
+  // past every accepted batch; a batch that fails stops the upload and is resent next cycle. Only a permanent
+  // rejection (4xx) is skipped, so one bad batch cannot block the log. Samples still buffered in RTC memory come last
+  // and are dropped from the buffer once accepted, they never reach flash. Every batch gets the transfer deadline of
+  // its own; once the session budget runs out the upload stops the same way and the next session resumes from the
+  // cursor. That only counts as a failed session if not a single batch got through.
+  LogReader reader(LoggingService::acknowledgedCursor());
+  LogCursor acknowledged        = reader.position();
+  size_t    acknowledgedPending = 0;
+  size_t    acceptedBatches     = 0;
+  size_t    failedLines         = 0;
+  bool      outOfTime           = false;
+  LogEntry  entry;
+  while (true) {
+    const LogCursor recordStart  = reader.position();
+    const size_t    pendingStart = reader.pendingRead();
+    const bool      hasEntry     = reader.next(entry);
+    if (hasEntry && encoder->add(entry))
       continue;
+    if (encoder->count() > 0) {
+      ModemSession::beginStage(ModemStage::Transfer);
+      if (ModemSession::expired()) {
+        DBG_PRINTF("[ComA7670E] Upload out of time after %u batches -> resuming next session\n", acceptedBatches);
+        failedLines = encoder->count();
+        outOfTime   = true;
+        break;
+      }
+      const int status = postTelegrafBatch(*encoder, authorization, compress ? &gzip : nullptr);
+      DBG_PRINTF("[ComA7670E] Sent batch of %u events, status: %d\n", encoder->count(), status);
+      const bool rejected = status >= 400 && status < 500 && status != 408 && status != 429;
+      if ((status < 200 || status > 299) && !rejected) {
+        DBG_PRINTLN("[ComA7670E] Batch not written correctly -> retry next cycle");
+        failedLines = encoder->count();
+        break;
+      }
+      if (rejected)
+        DBG_PRINTLN("[ComA7670E] Batch rejected by server -> dropping it");
+      acknowledged        = recordStart;
+      acknowledgedPending = pendingStart;
+      acceptedBatches += 1;
+      encoder->clear();
+      esp_task_wdt_reset();
+    }
+    if (!hasEntry)
+      break;
+    encoder->add(entry);  // always fits into an empty batch
+  }
+  clientTelegraf.stop();
+
+  // a single flash write for the whole upload
+  LoggingService::acknowledge(acknowledged);
+  LoggingService::dropPendingSamples(acknowledgedPending);
+  DBG_PRINTF("[ComA7670E] Log acknowledged up to %u:%u and %u buffered samples\n", acknowledged.segment,
+             acknowledged.offset, acknowledgedPending);
+
+  PersistentState::data().failedLines = failedLines;
+  if (failedLines > 0)
+    DBG_PRINTF("[ComA7670E] Failed %d lines, resending next cycle.\n", failedLines);
+  if (outOfTime && acceptedBatches == 0)
+    ModemSession::fail();
+  else if (failedLines == 0 || outOfTime)
+    ModemSession::succeed();  // a partial upload made progress, the rest follows next session without a backoff
+}
 
+int CommunicationA7670E::postTelegrafBatch(UploadEncoder& encoder, const String& authorization, GzipEncoder* gzip) {
+  size_t         length     = 0;
+  const uint8_t* payload    = encoder.finish(length);
+  const size_t   compressed = gzip != nullptr ? gzip->compress(payload, length) : 0;
+  if (compressed > 0) {
+    DBG_PRINTF("[ComA7670E] Compressed batch %u -> %u bytes\n", length, compressed);
+    payload = gzip->data();
+    length  = compressed;
+  }
 
-    DBG_PRINTF("[ComA7670E] Begin request:\n");
-    clientTelegraf.beginRequest();
-    clientTelegraf.post(HTTP_TELEGRAF_RESOURCE_MPPT);
-    clientTelegraf.sendHeader("Content-Type", "application/json");
-    String auth       = String(TELEGRAM_HTTP_USER) + ":" + TELEGRAM_HTTP_PASS;
-    String authBase64 = base64::encode(auth);
-    clientTelegraf.sendHeader("Authorization", "Basic " + authBase64);
-    clientTelegraf.sendHeader("Content-Length", String(line.length()));
-    clientTelegraf.endRequest();
-
-    DBG_PRINTF("[ComA7670E] Sending HTTP request\n");
-    clientTelegraf.print(line);
-    int    status       = clientTelegraf.responseStatusCode();
-    String responseBody = clientTelegraf.responseBody();
+  DBG_PRINTF("[ComA7670E] Begin request (%s connection):\n", clientTelegraf.connected() ? "reused" : "new");
+  clientTelegraf.setHttpResponseTimeout(ModemSession::remainingMs());
+  clientTelegraf.beginRequest();
+  clientTelegraf.post(encoder.resource());
+  clientTelegraf.sendHeader("Content-Type", encoder.contentType());
+  if (compressed > 0)
+    clientTelegraf.sendHeader("Content-Encoding", "gzip");
+  clientTelegraf.sendHeader("Authorization", authorization);
+  clientTelegraf.sendHeader("Content-Length", length);
+  clientTelegraf.endRequest();
+
+  DBG_PRINTF("[ComA7670E] Sending HTTP request\n");
+  clientTelegraf.write(payload, length);
+  const int status = clientTelegraf.responseStatusCode();
+  if (status < 0) {
+    // transport error, the connection state is unknown: drop it so the next batch reconnects
     clientTelegraf.stop();
-
-    DBG_PRINTF("[ComA7670E] Sent one event, status: %d\n", status);
-    if (status < 200 || status > 299) {
-      failedLines += 1;
-      DBG_PRINTLN(
-          "[ComA7670E] Line not written correctly -> moving "
-          "to .tmp");
-      tempFile.println(line);
-    }
-    esp_task_wdt_reset();
+    return status;
   }
-  original.close();
-  tempFile.close();
-  DBG_PRINTLN("[ComA7670E] Remove original file");
-  LittleFS.remove(MPPT_LOG_FILE_NAME);
-
-  // set failed lines count in Preferences
-  Preferences prefs;
-  prefs.begin(PREF_NAME, false);
-  prefs.putUInt(FAILED_LINES_COUNT, failedLines);
-  prefs.end();
-
-  if (failedLines > 0) {
-    DBG_PRINTF("[ComA7670E] Failed %d lines. Moving TMP to ORIGINAL.\n", failedLines);
-    LittleFS.rename(TEMP_FILE_NAME, MPPT_LOG_FILE_NAME);
-  } else
-    LittleFS.remove(TEMP_FILE_NAME);
+  // the body has to be consumed before the connection can carry the next request
+  clientTelegraf.responseBody();
+  return status;
 }
 
 void CommunicationA7670E::downloadConfig() {
+  PROFILE_PHASE(WakePhase::ConfigDownload);
   DBG_PRINTLN("[ComA7670E] Starting downloadConfig()");
 
   if (!isModemOn()) {
@@ -219,6 +402,8 @@ void CommunicationA7670E::downloadConfig() {
     return;
   }
 
+  ModemSession::beginStage(ModemStage::Transfer);
+  clientFastApi.setHttpResponseTimeout(ModemSession::remainingMs());
   clientFastApi.get("/");
 
   int status = clientFastApi.responseStatusCode();
@@ -235,6 +420,7 @@ void CommunicationA7670E::downloadConfig() {
 }
 
 void CommunicationA7670E::performOtaUpdate() {
+  PROFILE_PHASE(WakePhase::OtaUpdate);
   DBG_PRINTLN("[ComA7670E] Starting OTA update check...");
 
   if (!isModemOn() || !modem.isNetworkConnected()) {
@@ -243,6 +429,8 @@ void CommunicationA7670E::performOtaUpdate() {
   }
 
   // Step 1: Získaj firmware.json
+  ModemSession::beginStage(ModemStage::Transfer);
+  clientFastApi.setHttpResponseTimeout(ModemSession::remainingMs());
   clientFastApi.get("/firmware.json");
   if (clientFastApi.responseStatusCode() != 200) {
     DBG_PRINTLN("[ComA7670E] Failed to fetch firmware metadata");
@@ -279,6 +467,8 @@ void CommunicationA7670E::performOtaUpdate() {
     return;
   }
 
+  // the image download gets its own deadline; running out aborts the update, it is not a failed session
+  ModemSession::beginStage(ModemStage::Transfer, MODEM_DEADLINE_OTA_MS);
   uint8_t buffer[1024];
   int totalWritten = 0;
   int chunkIndex = 0;
@@ -317,6 +507,10 @@ void CommunicationA7670E::performOtaUpdate() {
     int retries = 0;
 
     while (readBytes < expectedSize && retries < 10) {
+      if (ModemSession::expired()) {
+        DBG_PRINTF("[ComA7670E] [Chunk %d] OTA out of time\n", chunkIndex);
+        break;
+      }
       int len = modem.https_body(buffer, sizeof(buffer));
       if (len <= 0) {
         retries++;
@@ -364,24 +558,51 @@ void CommunicationA7670E::performOtaUpdate() {
   }
 
   DBG_PRINTLN("[ComA7670E] OTA update successful. Rebooting...");
+  LoggingService::flushPendingSamples();
   delay(1500);
   ESP.restart();
 }
 
-int CommunicationA7670E::getSignalStrengthPercentage() {
-  if (modem.isNetworkConnected()) {
-    const int rssi = modem.getSignalQuality();  // 0–31
-    if (rssi == 99) {
-      return -1;
-    } else {
-      return (rssi * 100) / 31;
-    }
+void CommunicationA7670E::captureRadioMetrics(const RegStatus status) {
+  radioMetrics_              = {};
+  radioMetrics_.registration = static_cast<int8_t>(status);
+  radioMetrics_.csq          = static_cast<uint8_t>(modem.getSignalQuality());
+
+  String ueInfo;
+  if (modem.getSystemInformation(ueInfo)) {
+    DBG_PRINT(F("[ComA7670E] UE System Info: "));
+    DBG_PRINTLN(ueInfo);
+    radioMetrics_.parseSystemInformation(ueInfo.c_str());
   }
-  return -1;
+  DBG_PRINTF("[ComA7670E] Radio: CSQ %u, access %u, cell %u-%u 0x%X/%u, RSRP %d RSRQ %d SINR %d\n", radioMetrics_.csq,
+             static_cast<unsigned>(radioMetrics_.access), radioMetrics_.mcc, radioMetrics_.mnc, radioMetrics_.areaCode,
+             radioMetrics_.cellId, radioMetrics_.rsrp, radioMetrics_.rsrq, radioMetrics_.sinr);
 }
 
 void CommunicationA7670E::powerOffModemImpl() {
+#if MODEM_POWER_SAVING
+  if (psmGranted_) {
+    sleepAttached();
+    return;
+  }
+#endif
   modem.poweroff();
 }
 
+void CommunicationA7670E::sleepAttached() {
+  modem.sendAT(GF("+CSCLK=1"));
+  if (modem.waitResponse() != 1) {
+    DBG_PRINTLN(F("[ComA7670E] DTR sleep refused, powering off"));
+    modem.poweroff();
+    return;
+  }
+  // DTR high lets the modem sleep; the held pins keep it powered, out of reset and asleep while the ESP32 sleeps
+  digitalWrite(MODEM_DTR_PIN, HIGH);
+  for (const HeldPin& held : SLEEP_PINS)
+    gpio_hold_en(held.pin);
+  gpio_deep_sleep_hold_en();
+  asleep_ = true;
+  DBG_PRINTLN(F("[ComA7670E] Modem asleep, still attached"));
+}
+
 #endif
\ No newline at end of file
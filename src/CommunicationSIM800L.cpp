@@ -6,12 +6,19 @@
 #include <base64.h>
 #include <esp_task_wdt.h>
 
+#include "BufferPrint.h"
 #include "Globals.h"
 #include "LoadController.h"
+#include "LoggingService.h"
+#include "ModemSession.h"
+#include "PersistentState.h"
 #include "SolarMPPTMonitor.h"
 #include "TimeService.h"
+#include "WakeProfiler.h"
+#include "secrets.h"
 
-void CommunicationSIM800L::setupModemImpl() {
+bool CommunicationSIM800L::setupModemImpl() {
+  ModemSession::beginStage(ModemStage::PowerOn);
   // Start power management
   if (setupPMU() == false) {
     DBG_PRINTLN("[CommunicationSIM800L] Setting power error");
@@ -36,6 +43,8 @@ void CommunicationSIM800L::setupModemImpl() {
   SerialAT.begin(115200, SERIAL_8N1, MODEM_RX, MODEM_TX);
   while (!modem.testAT()) {
     DBG_PRINTLN("[CommunicationSIM800L] Waiting for modem...");
+    if (ModemSession::expired())
+      return false;
     delay(500);
   }
 
@@ -48,31 +57,38 @@ void CommunicationSIM800L::setupModemImpl() {
   DBG_PRINT("[CommunicationSIM800L] Modem Info: ");
   DBG_PRINTLN(modem.getModemInfo());
 
+  ModemSession::beginStage(ModemStage::Sim);
   if (GSM_PIN && modem.getSimStatus() != 3) {
     modem.simUnlock(GSM_PIN);
   }
   DBG_PRINT("[CommunicationSIM800L] Waiting for network...");
-  if (!modem.waitForNetwork()) {
+  ModemSession::beginStage(ModemStage::Registration);
+  if (!modem.waitForNetwork(ModemSession::remainingMs())) {
     DBG_PRINTLN(" fail");
-    delay(5000);
-    return;
+    return false;
   }
   DBG_PRINTLN(" success");
   if (modem.isNetworkConnected()) {
     DBG_PRINTLN("[CommunicationSIM800L] Network connected");
   }
+  // the SIM800L has no AT+CPSI, only signal quality and registration are known
+  radioMetrics_              = {};
+  radioMetrics_.registration = static_cast<int8_t>(modem.getRegistrationStatus());
+  radioMetrics_.csq          = static_cast<uint8_t>(modem.getSignalQuality());
+  radioMetrics_.access       = RadioAccess::Gsm;
   // GPRS connection parameters are usually set after network registration
   DBG_PRINT(F("[CommunicationSIM800L] Connecting to "));
   DBG_PRINT(APN);
+  ModemSession::beginStage(ModemStage::Pdp);
   if (!modem.gprsConnect(APN, GPRS_USER, GPRS_PWD)) {
     DBG_PRINTLN(" fail");
-    delay(10000);
-    return;
+    return false;
   }
   DBG_PRINTLN(" success");
   if (modem.isGprsConnected()) {
     DBG_PRINTLN("[CommunicationSIM800L] GPRS connected");
   }
+  return true;
 }
 
 bool CommunicationSIM800L::ensureNetwork() {
@@ -86,7 +102,8 @@ bool CommunicationSIM800L::ensureNetwork() {
       atOK = true;
       break;  // modem responded
     }
-    setupModem();
+    if (!setupModemImpl())
+      break;  // out of time
     delay(2000);  // small delay after restart
     attempts++;
   }
@@ -137,85 +154,95 @@ std::optional<timeval> CommunicationSIM800L::getTimeFromModem() {
   return std::nullopt;
 }
 
-void CommunicationSIM800L::sendMPPTPayload() {
+// posts one JSON object, streamed from printJson() into the request body; returns the HTTP status
+template <typename Item>
+int CommunicationSIM800L::postJson(const Item& item) {
+  LengthPrint  measure;
+  const size_t contentLength = item.printJson(measure);
+
+  DBG_PRINTF("[CommunicationSIM800L] Begin request:\n");
+  httpClientTelegraf.beginRequest();
+  httpClientTelegraf.post(HTTP_RESOURCE_MPPT);
+  httpClientTelegraf.sendHeader("Content-Type", "application/json");
+  String auth       = String(TELEGRAM_HTTP_USER) + ":" + TELEGRAM_HTTP_PASS;
+  String authBase64 = base64::encode(auth);
+  httpClientTelegraf.sendHeader("Authorization", "Basic " + authBase64);
+  httpClientTelegraf.sendHeader("Content-Length", String(contentLength));
+  httpClientTelegraf.endRequest();
+
+  DBG_PRINTF("[CommunicationSIM800L] Sending HTTP request\n");
+  item.printJson(httpClientTelegraf);
+  int    status       = httpClientTelegraf.responseStatusCode();
+  String responseBody = httpClientTelegraf.responseBody();
+  DBG_PRINTLN("[CommunicationSIM800L] Response body: " + String(responseBody));
+  httpClientTelegraf.stop();
+  return status;
+}
+
+void CommunicationSIM800L::sendMPPTPayload(const UploadFormat format) {
+  PROFILE_PHASE(WakePhase::Upload);
   if (!isModemOn()) {
     DBG_PRINTLN("[CommunicationSIM800L] Modem is offline.");
     return;
   }
-
-  File   original       = LittleFS.open(MPPT_LOG_FILE_NAME, FILE_READ);
-  String TEMP_FILE_NAME = String(MPPT_LOG_FILE_NAME) + ".tmp";
-  if (!original) {
-    DBG_PRINTLN("[CommunicationSIM800L]  File not found");
-    return;
-  }
-
-  File tempFile = LittleFS.open(TEMP_FILE_NAME.c_str(), "w");
-  if (!tempFile) {
-    DBG_PRINTLN("[CommunicationSIM800L]  Could not create temp file");
-    original.close();
-    return;
-  }
+  if (format != UploadFormat::Json)
+    DBG_PRINTF("[CommunicationSIM800L] Upload format %s not supported, sending JSON\n",
+               UPLOAD_FORMAT_NAMES[static_cast<size_t>(format)]);
 
   httpClientTelegraf.connect(HTTP_SERVER, HTTP_TELEGRAF_PORT);
   if (httpClientTelegraf.connected())
     DBG_PRINTF("[CommunicationSIM800L] HTTP Client Connected to %s:%d\n", HTTP_SERVER, HTTP_TELEGRAF_PORT);
 
-  size_t failedLines = 0;
-  while (original.available()) {
-    String line = original.readStringUntil('\n');
-    line.trim();
-    if (line.length() == 0)
-      continue;
-
+  // the wake report goes first, in a request of its own; it is captured anew next session if it does not get through
+  const WakeReport report = WakeReport::capture();
+  if (!report.isEmpty()) {
+    ModemSession::beginStage(ModemStage::Transfer);
     ensureNetwork();
+    DBG_PRINTF("[CommunicationSIM800L] Sent wake report, status: %d\n", postJson(report));
+  }
 
-    DBG_PRINTF("[CommunicationSIM800L] Begin request:\n");
-    httpClientTelegraf.beginRequest();
-    httpClientTelegraf.post(HTTP_RESOURCE_MPPT);
-    httpClientTelegraf.sendHeader("Content-Type", "application/json");
-    String auth       = String(TELEGRAM_HTTP_USER) + ":" + TELEGRAM_HTTP_PASS;
-    String authBase64 = base64::encode(auth);
-    httpClientTelegraf.sendHeader("Authorization", "Basic " + authBase64);
-    httpClientTelegraf.sendHeader("Content-Length", String(line.length()));
-    httpClientTelegraf.endRequest();
-
-    DBG_PRINTF("[CommunicationSIM800L] Sending HTTP request\n");
-    httpClientTelegraf.print(line);
-    int    status       = httpClientTelegraf.responseStatusCode();
-    String responseBody = httpClientTelegraf.responseBody();
-    DBG_PRINTLN("[CommunicationSIM800L] Response body: " + String(responseBody));
-    httpClientTelegraf.stop();
+  LogReader reader(LoggingService::acknowledgedCursor());
+  LogCursor acknowledged        = reader.position();
+  size_t    failedLines         = 0;
+  size_t    acknowledgedPending = 0;
+  size_t    sentLines           = 0;
+  bool      outOfTime           = false;
+  LogEntry  entry;
+  while (reader.next(entry)) {
+    ModemSession::beginStage(ModemStage::Transfer);  // the deadline covers one request
+    if (ModemSession::expired()) {
+      DBG_PRINTF("[CommunicationSIM800L] Upload out of time after %u lines -> resuming next session\n", sentLines);
+      failedLines += 1;
+      outOfTime = true;
+      break;
+    }
+    ensureNetwork();
+    const int status = postJson(entry);
 
     DBG_PRINTF("[CommunicationSIM800L] Sent one event, status: %d\n", status);
     if (status < 200 || status > 299) {
       failedLines += 1;
-      DBG_PRINTLN(
-          "[CommunicationSIM800L] Line not written correctly -> moving "
-          "to .tmp");
-      tempFile.println(line);
+      DBG_PRINTLN("[CommunicationSIM800L] Line not written correctly -> retry next cycle");
+      break;
     }
+    acknowledged        = reader.position();
+    acknowledgedPending = reader.pendingRead();
+    sentLines += 1;
     esp_task_wdt_reset();
   }
-  original.close();
-  tempFile.close();
-  DBG_PRINTLN("[CommunicationSIM800L] Remove original file");
-  LittleFS.remove(MPPT_LOG_FILE_NAME);
-
-  // set failed lines count in Preferences
-  Preferences prefs;
-  prefs.begin(PREF_NAME, false);
-  prefs.putUInt(FAILED_LINES_COUNT, failedLines);
-  prefs.end();
-
-  if (failedLines > 0) {
-    DBG_PRINTF("[CommunicationSIM800L] Failed %d lines. Moving TMP to ORIGINAL.\n", failedLines);
-    LittleFS.rename(TEMP_FILE_NAME, MPPT_LOG_FILE_NAME);
-  } else
-    LittleFS.remove(TEMP_FILE_NAME);
+  // a single flash write for the whole upload
+  LoggingService::acknowledge(acknowledged);
+  LoggingService::dropPendingSamples(acknowledgedPending);
+
+  PersistentState::data().failedLines = failedLines;
+  if (outOfTime && sentLines == 0)
+    ModemSession::fail();
+  else if (failedLines == 0 || outOfTime)
+    ModemSession::succeed();
 }
 
 void CommunicationSIM800L::downloadConfig() {
+  PROFILE_PHASE(WakePhase::ConfigDownload);
   if (!isModemOn()) {
     DBG_PRINTLN("[CommunicationSIM800L] Modem is offline.");
     return;
@@ -224,6 +251,8 @@ void CommunicationSIM800L::downloadConfig() {
     DBG_PRINTLN("[CommunicationSIM800L] Cannot send data, network is not ready.");
     return;  // handle offline scenario
   }
+  ModemSession::beginStage(ModemStage::Transfer);
+  httpClientFastApi.setHttpResponseTimeout(ModemSession::remainingMs());
   httpClientFastApi.connect(HTTP_SERVER, HTTP_API_PORT);
   if (httpClientFastApi.connected())
     DBG_PRINTF("[CommunicationSIM800L] HTTP Client Connected to %s:%d\n", HTTP_SERVER, HTTP_TELEGRAF_PORT);
@@ -242,18 +271,6 @@ bool CommunicationSIM800L::setupPMU() {
   return Wire.endTransmission() == 0;
 }
 
-int CommunicationSIM800L::getSignalStrengthPercentage() {
-  if (modem.isNetworkConnected()) {
-    const int rssi = modem.getSignalQuality();  // 0–31
-    if (rssi == 99) {
-      return -1;
-    } else {
-      return (rssi * 100) / 31;
-    }
-  }
-  return -1;
-}
-
 void CommunicationSIM800L::powerOffModemImpl() {
   modem.poweroff();
 }
@@ -0,0 +1,85 @@
+#include "EnergyModel.h"
+
+#if MPPT_WAKE_PROFILE
+#include <esp_attr.h>
+
+#include "TimeService.h"
+
+namespace {
+constexpr uint32_t MAGIC = 0x454C4731;  // "ELG1"
+
+struct Ledger {
+  uint32_t magic;
+  int32_t  day;  // year * 1000 + day of the year, local time
+  float    lastWakeMas;
+  float    todayMas[ENERGY_CONSUMER_COUNT];
+};
+
+RTC_DATA_ATTR Ledger ledger;
+
+float seconds(const uint32_t (&phaseUs)[WAKE_PHASE_COUNT], const WakePhase phase) {
+  return phaseUs[static_cast<size_t>(phase)] / 1e6f;
+}
+}  // namespace
+
+float WakeCharge::total() const {
+  float sum = 0;
+  for (const float charge : mAs)
+    sum += charge;
+  return sum;
+}
+
+WakeCharge EnergyModel::wakeCharge(const uint32_t (&phaseUs)[WAKE_PHASE_COUNT], const uint32_t sleepSeconds) const {
+  WakeCharge charge{};
+  charge.mAs[static_cast<size_t>(EnergyConsumer::Cpu)] = currents_.cpuActive * seconds(phaseUs, WakePhase::Awake);
+
+  if (phaseUs[static_cast<size_t>(WakePhase::ModemSetup)] > 0) {
+    const float attached = seconds(phaseUs, WakePhase::ModbusPoll) + seconds(phaseUs, WakePhase::LogAppend) +
+                           seconds(phaseUs, WakePhase::ModemWait) + seconds(phaseUs, WakePhase::SleepEntry);
+    charge.mAs[static_cast<size_t>(EnergyConsumer::ModemRegister)] = currents_.modemRegister * attached;
+  }
+  const float transfers = seconds(phaseUs, WakePhase::ConfigDownload) + seconds(phaseUs, WakePhase::OtaUpdate) +
+                          seconds(phaseUs, WakePhase::Upload);
+  charge.mAs[static_cast<size_t>(EnergyConsumer::ModemTransmit)] = currents_.modemTransmit * transfers;
+  charge.mAs[static_cast<size_t>(EnergyConsumer::Rs485)] = currents_.rs485 * seconds(phaseUs, WakePhase::ModbusPoll);
+  charge.mAs[static_cast<size_t>(EnergyConsumer::DeepSleep)] = currents_.deepSleep * sleepSeconds;
+  return charge;
+}
+
+float EnergySummary::todayTotalMwh() const {
+  float sum = 0;
+  for (const float energy : todayMwh)
+    sum += energy;
+  return sum;
+}
+
+void EnergyLedger::addWake(const WakeCharge& charge, const time_t now) {
+  if (ledger.magic != MAGIC)
+    ledger = {MAGIC, -1, 0, {}};
+  if (isTimeInitializedFromModem) {
+    tm local;
+    localtime_r(&now, &local);
+    const int32_t day = (local.tm_year + 1900) * 1000 + local.tm_yday;
+    if (day != ledger.day) {
+      ledger.day = day;
+      for (float& total : ledger.todayMas)
+        total = 0;
+    }
+  }
+  for (size_t i = 0; i < ENERGY_CONSUMER_COUNT; ++i)
+    ledger.todayMas[i] += charge.mAs[i];
+  ledger.lastWakeMas = charge.total();
+  DBG_PRINTF("[EnergyLedger] Wake: %.1f mAs, today: %.1f mWh\n", ledger.lastWakeMas, summary().todayTotalMwh());
+}
+
+EnergySummary EnergyLedger::summary() {
+  EnergySummary summary{};
+  if (ledger.magic != MAGIC)
+    return summary;
+  summary.wakeMas = ledger.lastWakeMas;
+  for (size_t i = 0; i < ENERGY_CONSUMER_COUNT; ++i)
+    summary.todayMwh[i] = EnergyModel::toMilliwattHours(ledger.todayMas[i], ENERGY_SUPPLY_VOLTAGE);
+  return summary;
+}
+
+#endif
@@ -0,0 +1,51 @@
+#include "GzipEncoder.h"
+
+#include <esp32/rom/crc.h>
+
+#include "Globals.h"
+
+GzipEncoder::GzipEncoder(const size_t maxInputSize)
+    // deflate may grow incompressible input slightly
+    : capacity_(HEADER_SIZE + maxInputSize + maxInputSize / 8 + 64 + TRAILER_SIZE) {}
+
+GzipEncoder::~GzipEncoder() {
+  free(compressor_);
+  free(output_);
+}
+
+bool GzipEncoder::begin() {
+  if (compressor_ == nullptr)
+    compressor_ = static_cast<tdefl_compressor*>(ps_malloc(sizeof(tdefl_compressor)));
+  if (output_ == nullptr)
+    output_ = static_cast<uint8_t*>(ps_malloc(capacity_));
+  if (compressor_ == nullptr || output_ == nullptr) {
+    DBG_PRINTF("[GzipEncoder] Could not allocate %u bytes in PSRAM\n", sizeof(tdefl_compressor) + capacity_);
+    return false;
+  }
+  return true;
+}
+
+size_t GzipEncoder::compress(const uint8_t* data, const size_t length) {
+  if (compressor_ == nullptr || output_ == nullptr)
+    return 0;
+
+  // magic, CM = deflate, no flags, no mtime, XFL = 0, OS = unknown
+  static constexpr uint8_t HEADER[HEADER_SIZE] = {0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF};
+  memcpy(output_, HEADER, HEADER_SIZE);
+
+  // raw deflate stream (no zlib header), default lazy matching
+  tdefl_init(compressor_, nullptr, nullptr, TDEFL_DEFAULT_MAX_PROBES);
+  size_t inSize  = length;
+  size_t outSize = capacity_ - HEADER_SIZE - TRAILER_SIZE;
+  if (tdefl_compress(compressor_, data, &inSize, output_ + HEADER_SIZE, &outSize, TDEFL_FINISH) != TDEFL_STATUS_DONE ||
+      inSize != length)
+    return 0;
+
+  // CRC-32 and size of the uncompressed data, little endian like the ESP32 itself
+  const uint32_t crc  = crc32_le(0, data, length);
+  const uint32_t size = length;
+  uint8_t*       tail = output_ + HEADER_SIZE + outSize;
+  memcpy(tail, &crc, sizeof(crc));
+  memcpy(tail + sizeof(crc), &size, sizeof(size));
+  return HEADER_SIZE + outSize + TRAILER_SIZE;
+}
@@ -0,0 +1,74 @@
+#include "ICommunicationService.h"
+
+#include <esp_attr.h>
+#include <esp_timer.h>
+
+RTC_DATA_ATTR RadioMetrics ICommunicationService::sessionRadioMetrics_;
+
+void ICommunicationService::startModem() {
+  if (isModemOn_ || modemTask_ != nullptr)
+    return;
+  if (modemEvents_ == nullptr)
+    modemEvents_ = xEventGroupCreate();
+  xEventGroupClearBits(modemEvents_, MODEM_READY);
+  radioMetrics_ = {};
+  ModemSession::start();
+
+  // the other core than the one running loop(), which keeps reading the MPPT
+  const BaseType_t core = xPortGetCoreID() == 0 ? 1 : 0;
+  if (xTaskCreatePinnedToCore(modemTask, "modem", MODEM_TASK_STACK, this, 1, &modemTask_, core) != pdPASS) {
+    DBG_PRINTLN("[ICommunicationService] Modem task not created, starting the modem inline");
+    modemTask_ = nullptr;
+    {
+      PROFILE_PHASE(WakePhase::ModemSetup);
+      modemReady_ = setupModemImpl();
+    }
+    finishSetup();
+  }
+}
+
+void ICommunicationService::modemTask(void* service) {
+  auto* self = static_cast<ICommunicationService*>(service);
+
+  const int64_t start = esp_timer_get_time();
+  self->modemReady_   = self->setupModemImpl();
+  self->modemSetupUs_ = static_cast<uint32_t>(esp_timer_get_time() - start);
+  xEventGroupSetBits(self->modemEvents_, MODEM_READY);
+  vTaskDelete(nullptr);
+}
+
+bool ICommunicationService::waitForModem() {
+  if (modemTask_ == nullptr)
+    return isModemOn_;
+  {
+    PROFILE_PHASE(WakePhase::ModemWait);
+    // bounded by the ModemSession deadlines of the bring-up
+    xEventGroupWaitBits(modemEvents_, MODEM_READY, pdFALSE, pdTRUE, portMAX_DELAY);
+  }
+  modemTask_ = nullptr;
+#if MPPT_WAKE_PROFILE
+  WakeProfiler::record(WakePhase::ModemSetup, modemSetupUs_);
+#endif
+  DBG_PRINTF("[ICommunicationService] Modem setup done after %u ms\n", modemSetupUs_ / 1000);
+  finishSetup();
+  return isModemOn_;
+}
+
+void ICommunicationService::finishSetup() {
+  sessionRadioMetrics_ = radioMetrics_;
+  if (modemReady_) {
+    isModemOn_ = true;
+    return;
+  }
+  DBG_PRINTF("[ICommunicationService] Modem not ready (%s), powering it off\n",
+             MODEM_STAGE_NAMES[static_cast<size_t>(ModemSession::stage())]);
+  ModemSession::fail();
+  powerOffModemImpl();
+}
+
+void ICommunicationService::powerOffModem() {
+  waitForModem();
+  if (isModemOn_)
+    powerOffModemImpl();
+  isModemOn_ = false;
+}
@@ -1,23 +1,22 @@
 #include "LoadController.h"
 
+#include "PersistentState.h"
 #include "SolarMPPTMonitor.h"
 #include "TimeService.h"
+#include "WakeProfiler.h"
 
 LoadController::LoadController() = default;
 
 void LoadController::setup() {
-  Preferences prefs;
-  prefs.begin(PREF_NAME, true);  // open namespace in read-only mode
-  nextLoadOn_  = prefs.getULong64("nextOn", 0);
-  nextLoadOff_ = prefs.getULong64("nextOff", 0);
-  prefs.end();
+  PROFILE_PHASE(WakePhase::LoadSetup);
+  nextLoadOn_  = PersistentState::data().nextLoadOn;
+  nextLoadOff_ = PersistentState::data().nextLoadOff;
 
   DBG_PRINTF("[LoadController] Loaded nextLoadOn=%ld, nextLoadOff=%ld\n", (long) nextLoadOn_, (long) nextLoadOff_);
 }
 
 void LoadController::updateConfigAndTime(const String& payload) {
   JsonDocument doc;
-  Preferences  prefs;
 
   DeserializationError error = deserializeJson(doc, payload);
   if (error) {
@@ -50,12 +49,25 @@ void LoadController::updateConfigAndTime(const String& payload) {
   tv.tv_usec = 0;
   TimeService::setESPTimeFromModem(tv);
 
-  prefs.begin(PREF_NAME, false);
-  prefs.putULong64("nextOn", (uint64_t) nextLoadOn_);
-  prefs.putULong64("nextOff", (uint64_t) nextLoadOff_);
-  prefs.end();
+  PersistentState::data().nextLoadOn  = nextLoadOn_;
+  PersistentState::data().nextLoadOff = nextLoadOff_;
 
   DBG_PRINTF("[LoadController] Saved nextLoadOn=%ld, nextLoadOff=%ld\n", (long) nextLoadOn_, (long) nextLoadOff_);
+
+  // optional: switches the upload format without a firmware update, a name this firmware does not know means JSON
+  const char*  uploadFormatStr = doc["uploadFormat"];
+  UploadFormat format          = MPPT_UPLOAD_FORMAT;
+  if (uploadFormatStr != nullptr && !parseUploadFormat(uploadFormatStr, format)) {
+    DBG_PRINTF("[LoadController] Unknown upload format %s, using json\n", uploadFormatStr);
+    format = UploadFormat::Json;
+  }
+  PersistentState::data().uploadFormat = uploadFormatStr != nullptr ? static_cast<uint8_t>(format) : UINT8_MAX;
+  DBG_PRINTF("[LoadController] Upload format: %s\n", UPLOAD_FORMAT_NAMES[static_cast<size_t>(uploadFormat())]);
+}
+
+UploadFormat LoadController::uploadFormat() {
+  const uint8_t stored = PersistentState::data().uploadFormat;
+  return stored < UPLOAD_FORMAT_COUNT ? static_cast<UploadFormat>(stored) : MPPT_UPLOAD_FORMAT;
 }
 
 bool isInWindow(time_t current, time_t on, time_t off) {
@@ -0,0 +1,153 @@
+#include "LogChunkEncoder.h"
+
+#include <cstring>
+
+// tokens carry a tag bit on top of a zig-zag encoded delta, the mask deltas must leave room for both
+static_assert(mpptReadRegistersCount <= 62, "validity mask deltas must fit 62 bits");
+
+namespace {
+class ChunkWriter {
+ public:
+  ChunkWriter(uint8_t* out, const size_t capacity) : out_(out), capacity_(capacity) {}
+
+  void byte(const uint8_t value) {
+    if (length_ < capacity_)
+      out_[length_] = value;
+    ++length_;
+  }
+
+  void varint(uint64_t value) {
+    while (value >= 0x80) {
+      byte(static_cast<uint8_t>(value) | 0x80);
+      value >>= 7;
+    }
+    byte(static_cast<uint8_t>(value));
+  }
+
+  void text(const char* value) {
+    const size_t length = strlen(value);
+    byte(static_cast<uint8_t>(length));
+    for (size_t i = 0; i < length && i < UINT8_MAX; ++i)
+      byte(value[i]);
+  }
+
+  [[nodiscard]] size_t size() const { return length_ <= capacity_ ? length_ : 0; }
+
+ private:
+  uint8_t*     out_;
+  const size_t capacity_;
+  size_t       length_ = 0;
+};
+
+uint64_t zigZag(const int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+}  // namespace
+
+int64_t LogChunkEncoder::columnValue(const LogEntry& entry, const size_t column) {
+  switch (column) {
+    case 0:
+      return entry.ts;
+    case 1:
+      return entry.loadState;
+    case 2:
+      return entry.radio.signalPercentage();
+    case 3:
+      return entry.totalWakeTime;
+    case 4:
+      return entry.modemSyncTime;
+    case 5:
+      return static_cast<int64_t>(entry.values.validMask);
+    default:
+      break;
+  }
+  if (column < ENTRY_COLUMNS + mpptReadRegistersCount) {
+    const size_t index = column - ENTRY_COLUMNS;
+    return signedRegisterValue(mpptReadRegisters[index], entry.values.raw[index]);
+  }
+  if (column >= ENTRY_COLUMNS + mpptReadRegistersCount + LINK_COLUMNS)
+    return radioValue(entry.radio, column - ENTRY_COLUMNS - mpptReadRegistersCount - LINK_COLUMNS);
+  const LinkErrorCounters& link = entry.linkCounters;
+  switch (column - ENTRY_COLUMNS - mpptReadRegistersCount) {
+    case 0:
+      return link.transactions;
+    case 1:
+      return link.timeouts;
+    case 2:
+      return link.crcErrors;
+    case 3:
+      return link.exceptions;
+    case 4:
+      return link.uartResets;
+    case 5:
+      return link.skipped;
+    default:
+      return link.breakerOpen;
+  }
+}
+
+int64_t LogChunkEncoder::radioValue(const RadioMetrics& radio, const size_t column) {
+  switch (column) {
+    case 0:
+      return radio.registration;
+    case 1:
+      return static_cast<int64_t>(radio.access);
+    case 2:
+      return radio.mcc;
+    case 3:
+      return radio.mnc;
+    case 4:
+      return radio.areaCode;
+    case 5:
+      return radio.cellId;
+    case 6:
+      return radio.rsrp;
+    case 7:
+      return radio.rsrq;
+    default:
+      return radio.sinr;
+  }
+}
+
+size_t LogChunkEncoder::encode(const LogEntry* entries, const size_t count, uint8_t* out, const size_t capacity) {
+  if (count == 0)
+    return 0;
+
+  ChunkWriter writer(out, capacity);
+  writer.byte(MAGIC[0]);
+  writer.byte(MAGIC[1]);
+  writer.byte(VERSION);
+  writer.text(MY_ESP_DEVICE_ID);
+  writer.text(MPPT_FIRMWARE_VERSION);
+  writer.varint(count);
+  writer.byte(mpptReadRegistersCount);
+  for (const auto& reg : mpptReadRegisters) {
+    writer.byte(reg.address & 0xFF);
+    writer.byte(reg.address >> 8);
+    writer.byte(static_cast<uint8_t>(reg.type << 4 | registerDecimals(reg)));
+  }
+
+  for (size_t column = 0; column < COLUMNS; ++column) {
+    int64_t previous = columnValue(entries[0], column);
+    int64_t delta    = 0;
+    size_t  repeats  = 0;
+    writer.varint(zigZag(previous));
+    for (size_t i = 1; i < count; ++i) {
+      const int64_t value     = columnValue(entries[i], column);
+      const int64_t nextDelta = value - previous;
+      previous                = value;
+      if (nextDelta == delta) {
+        ++repeats;
+        continue;
+      }
+      if (repeats > 0)
+        writer.varint(static_cast<uint64_t>(repeats) << 1 | 1);
+      writer.varint(zigZag(nextDelta) << 1);
+      delta   = nextDelta;
+      repeats = 0;
+    }
+    if (repeats > 0)
+      writer.varint(static_cast<uint64_t>(repeats) << 1 | 1);
+  }
+  return writer.size();
+}
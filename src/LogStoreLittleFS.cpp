@@ -0,0 +1,160 @@
+#ifndef MPPT_LOG_PARTITION
+#include "LoggingService.h"
+
+bool LoggingService::setupStore() {
+  if (!LittleFS.begin(true)) {
+    // `true` will format if mount fails
+    DBG_PRINTLN("[LoggingService] LittleFS mount failed!");
+    return false;
+  }
+  DBG_PRINTLN("[LoggingService] LittleFS mounted.");
+  if (!LittleFS.exists(MPPT_LOG_DIR))
+    LittleFS.mkdir(MPPT_LOG_DIR);
+  DBG_PRINTF("[LoggingService] Log acknowledged up to %u:%u, writing segment %u\n", state_.acknowledged.segment,
+             state_.acknowledged.offset, state_.writeSegment);
+  migrateLegacyLog();
+  return true;
+}
+
+/**
+ * Moves the samples firmware <= 1.1.6 left unsent in its JSON log into the store, so the next upload sends them. The
+ * file is removed only once every line is stored; after a failed write the whole file is migrated again next time,
+ * the repeated samples carry their original timestamps and overwrite themselves on the server.
+ */
+void LoggingService::migrateLegacyLog() {
+  if (!LittleFS.exists(MPPT_LEGACY_LOG_FILE_NAME))
+    return;
+  File legacy = LittleFS.open(MPPT_LEGACY_LOG_FILE_NAME, FILE_READ);
+  if (!legacy) {
+    DBG_PRINTLN("[LoggingService] Failed to open legacy JSON log file");
+    return;
+  }
+  size_t   migrated = 0, skipped = 0;
+  bool     stored   = true;
+  LogEntry entry;
+  while (stored && legacy.available()) {
+    const String line = legacy.readStringUntil('\n');
+    if (!LogEntry::fromLegacyJson(line, entry)) {
+      skipped += line.length() > 0;
+      continue;
+    }
+    const LogRecord record = LogRecord::fromEntry(entry);
+    stored                 = storeRecords(&record, 1) == 1;
+    migrated += stored;
+  }
+  legacy.close();
+  if (!stored) {
+    DBG_PRINTF("[LoggingService] Legacy JSON log: stored %u lines before a write failed, keeping the file\n", migrated);
+    return;
+  }
+  DBG_PRINTF("[LoggingService] Migrated %u lines of the legacy JSON log, skipped %u unreadable ones\n", migrated,
+             skipped);
+  LittleFS.remove(MPPT_LEGACY_LOG_FILE_NAME);
+}
+
+String LoggingService::segmentPath(const uint32_t segment) {
+  return String(MPPT_LOG_DIR) + "/" + String(segment) + ".bin";
+}
+
+size_t LoggingService::storeRecords(const LogRecord* records, const size_t count) {
+  File f = LittleFS.open(segmentPath(state_.writeSegment), FILE_APPEND);
+  if (!f) {
+    DBG_PRINTLN("[LoggingService] Failed to open log file for appending");
+    return 0;
+  }
+  // a full segment, or one ending in a torn record, is closed: appending behind a partial record would misalign it
+  if (f.size() >= MPPT_LOG_SEGMENT_BYTES || f.size() % sizeof(LogRecord) != 0) {
+    f.close();
+    ++state_.writeSegment;
+    saveState();
+    DBG_PRINTF("[LoggingService] Starting log segment %u\n", state_.writeSegment);
+    f = LittleFS.open(segmentPath(state_.writeSegment), FILE_APPEND);
+    if (!f) {
+      DBG_PRINTLN("[LoggingService] Failed to open log file for appending");
+      return 0;
+    }
+  }
+  size_t consumed = 0;
+  for (; consumed < count; ++consumed) {
+    if (!records[consumed].isValid()) {
+      DBG_PRINTLN("[LoggingService] Dropping corrupted buffered sample");
+      continue;
+    }
+    if (f.write(reinterpret_cast<const uint8_t*>(&records[consumed]), sizeof(LogRecord)) != sizeof(LogRecord))
+      break;
+  }
+  f.close();
+  return consumed;
+}
+
+/**
+ * Reads the next valid record. Records with a bad header or CRC are skipped, a truncated record at the end of the
+ * file (power loss during append) ends the read. Returns false when no further record is available.
+ */
+bool LoggingService::readLogEntry(File& file, LogEntry& log) {
+  LogRecord record;
+  while (file.read(reinterpret_cast<uint8_t*>(&record), sizeof(record)) == sizeof(record)) {
+    if (!record.isValid()) {
+      DBG_PRINTLN("[LoggingService] Skipping corrupted log record");
+      continue;
+    }
+    log = record.entry;
+    return true;
+  }
+  return false;
+}
+
+/**
+ * Moves the acknowledged cursor forward and deletes the segments that lie completely behind it. The cursor is
+ * persisted first, so a reset in between leaves stale segments at worst, never unacknowledged data deleted.
+ */
+void LoggingService::acknowledge(const LogCursor& cursor) {
+  if (cursor.segment == state_.acknowledged.segment && cursor.offset == state_.acknowledged.offset)
+    return;
+  const uint32_t firstSegment = state_.acknowledged.segment;
+  state_.acknowledged         = cursor;
+  saveState();
+  for (uint32_t segment = firstSegment; segment < cursor.segment; ++segment)
+    LittleFS.remove(segmentPath(segment));
+}
+
+bool LoggingService::clearLogFile() {
+  DBG_PRINTLN("[LoggingService] Clearing log file.");
+  dropPendingSamples(pendingSamples());
+  if (!openStore())
+    return false;
+  bool removed = true;
+  for (uint32_t segment = state_.acknowledged.segment; segment <= state_.writeSegment; ++segment)
+    removed &= !LittleFS.exists(segmentPath(segment)) || LittleFS.remove(segmentPath(segment));
+  ++state_.writeSegment;
+  state_.acknowledged = {state_.writeSegment, 0};
+  saveState();
+  return removed;
+}
+
+LogReader::~LogReader() {
+  file_.close();
+}
+
+bool LogReader::nextStored(LogEntry& entry) {
+  while (true) {
+    if (!opened_) {
+      file_   = LittleFS.open(LoggingService::segmentPath(cursor_.segment), FILE_READ);
+      opened_ = true;
+      if (file_)
+        file_.seek(cursor_.offset);
+    }
+    if (file_ && LoggingService::readLogEntry(file_, entry)) {
+      cursor_.offset = file_.position();
+      return true;
+    }
+    if (cursor_.segment >= LoggingService::writeSegment())
+      return false;
+    // segment exhausted and closed for writing, continue with the next one
+    file_.close();
+    opened_ = false;
+    cursor_ = {cursor_.segment + 1, 0};
+  }
+}
+
+#endif
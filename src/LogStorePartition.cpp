@@ -0,0 +1,223 @@
+#ifdef MPPT_LOG_PARTITION
+#include <esp32/rom/crc.h>
+#include <esp_partition.h>
+
+#include <algorithm>
+
+#include "LoggingService.h"
+
+/**
+ * Circular log in a raw data partition.
+ *
+ * Every sector holds SLOTS_PER_SECTOR fixed-size slots, a slot never crosses a sector boundary. Record n (its sequence
+ * number) always lives in slot n % slotCount, so reading a sequence number needs no index. A sector is erased right
+ * before its first slot is written, which drops the oldest records once the log has wrapped around.
+ *
+ * At boot the head is found by binary search over the sequence numbers in the first slot of each sector: starting at
+ * sector 0 they increase up to the newest sector and are older (or erased) after it. The head is only accepted when the
+ * newest record sits intact in its slot; anything else is not a log and the partition is erased.
+ */
+namespace {
+struct Slot {
+  uint32_t  sequence;
+  uint32_t  crc;  // over sequence and record, binds the record to its position
+  LogRecord record;
+};
+
+constexpr uint32_t SECTOR_SIZE      = SPI_FLASH_SEC_SIZE;
+constexpr uint32_t SLOTS_PER_SECTOR = SECTOR_SIZE / sizeof(Slot);
+constexpr uint32_t ERASED           = 0xFFFFFFFF;
+static_assert(SLOTS_PER_SECTOR > 0, "LogRecord does not fit into a flash sector");
+
+const esp_partition_t* partition      = nullptr;
+uint32_t               sectorCount    = 0;
+uint32_t               slotCount      = 0;
+uint32_t               nextSequence   = 0;  // sequence number of the next record written
+uint32_t               oldestSequence = 0;  // oldest record not overwritten yet
+
+size_t slotAddress(const uint32_t slot) {
+  return (slot / SLOTS_PER_SECTOR) * SECTOR_SIZE + (slot % SLOTS_PER_SECTOR) * sizeof(Slot);
+}
+
+uint32_t readSequence(const uint32_t slot) {
+  uint32_t sequence = ERASED;
+  esp_partition_read(partition, slotAddress(slot), &sequence, sizeof(sequence));
+  return sequence;
+}
+
+uint32_t slotCrc(const Slot& slot) {
+  const uint32_t crc = crc32_le(0, reinterpret_cast<const uint8_t*>(&slot.sequence), sizeof(slot.sequence));
+  return crc32_le(crc, reinterpret_cast<const uint8_t*>(&slot.record), sizeof(slot.record));
+}
+
+// the slot holds record `sequence`, intact
+bool holdsRecord(const uint32_t slot, const uint32_t sequence) {
+  Slot stored;
+  esp_partition_read(partition, slotAddress(slot), &stored, sizeof(stored));
+  return stored.sequence == sequence && sequence % slotCount == slot && stored.crc == slotCrc(stored);
+}
+
+void format() {
+  DBG_PRINTLN("[LoggingService] Log partition not formatted, erasing it");
+  esp_partition_erase_range(partition, 0, partition->size);
+  nextSequence   = 0;
+  oldestSequence = 0;
+}
+
+uint32_t oldestSurvivingSequence() {
+  if (nextSequence == 0)
+    return 0;
+  // the partition holds the newest sectorCount sectors' worth of sequence numbers
+  const int64_t newestSector = (nextSequence - 1) / SLOTS_PER_SECTOR;
+  return static_cast<uint32_t>(std::max<int64_t>(0, (newestSector - (sectorCount - 1)) * SLOTS_PER_SECTOR));
+}
+
+void recover() {
+  nextSequence   = 0;
+  oldestSequence = 0;
+
+  const uint32_t firstSequence = readSequence(0);
+  uint32_t       low = 0, high = sectorCount - 1;
+  if (firstSequence == ERASED) {
+    // either a fresh log, or power was lost between erasing sector 0 and writing to it after a wrap-around
+    if (readSequence(high * SLOTS_PER_SECTOR) == ERASED) {
+      // a fresh log is erased throughout, leftovers in a sector would mislead the search once the log grows into it
+      for (uint32_t sector = 1; sector < high; ++sector) {
+        if (readSequence(sector * SLOTS_PER_SECTOR) != ERASED) {
+          format();
+          return;
+        }
+      }
+      return;
+    }
+    low = high;
+  } else if (firstSequence % slotCount != 0) {
+    format();
+    return;
+  }
+
+  // last sector whose first sequence continues the run started in sector 0
+  while (low < high) {
+    const uint32_t middle   = (low + high + 1) / 2;
+    const uint32_t sequence = readSequence(middle * SLOTS_PER_SECTOR);
+    if (sequence != ERASED && sequence >= firstSequence)
+      low = middle;
+    else
+      high = middle - 1;
+  }
+
+  // newest written slot in that sector; a torn slot counts as written, flash cannot be rewritten without an erase
+  uint32_t lastSlot = low * SLOTS_PER_SECTOR;
+  uint32_t last     = readSequence(lastSlot);
+  for (uint32_t i = 1; i < SLOTS_PER_SECTOR; ++i) {
+    const uint32_t sequence = readSequence(low * SLOTS_PER_SECTOR + i);
+    if (sequence == ERASED)
+      break;
+    lastSlot = low * SLOTS_PER_SECTOR + i;
+    last     = sequence;
+  }
+
+  // data left over from another partition layout (mpptlog overlaps the old spiffs range) does not pass as a log: the
+  // newest record, or the one before it when the newest was torn by a power loss, has to sit in its slot intact
+  const uint32_t previousSlot = (lastSlot + slotCount - 1) % slotCount;
+  if (!holdsRecord(lastSlot, last) && (last == 0 || !holdsRecord(previousSlot, last - 1))) {
+    format();
+    return;
+  }
+  nextSequence   = last + 1;
+  oldestSequence = oldestSurvivingSequence();
+}
+}  // namespace
+
+bool LoggingService::setupStore() {
+  partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, MPPT_LOG_PARTITION_LABEL);
+  if (partition == nullptr) {
+    DBG_PRINTLN("[LoggingService] Log partition not found!");
+    return true;  // nothing to retry, storeRecords() drops the samples
+  }
+  sectorCount = partition->size / SECTOR_SIZE;
+  slotCount   = sectorCount * SLOTS_PER_SECTOR;
+  recover();
+  if (state_.acknowledged.segment > nextSequence) {
+    // the partition was erased or reflashed behind our back
+    state_.acknowledged = {oldestSequence, 0};
+    saveState();
+  }
+  DBG_PRINTF("[LoggingService] Log partition: %u slots, records %u..%u, acknowledged up to %u\n", slotCount,
+             oldestSequence, nextSequence, state_.acknowledged.segment);
+  return true;
+}
+
+size_t LoggingService::storeRecords(const LogRecord* records, const size_t count) {
+  if (partition == nullptr) {
+    DBG_PRINTLN("[LoggingService] Log partition not available");
+    return 0;
+  }
+  size_t consumed = 0;
+  for (; consumed < count; ++consumed) {
+    if (!records[consumed].isValid()) {
+      DBG_PRINTLN("[LoggingService] Dropping corrupted buffered sample");
+      continue;
+    }
+    const uint32_t slot = nextSequence % slotCount;
+    if (slot % SLOTS_PER_SECTOR == 0) {
+      if (esp_partition_erase_range(partition, slotAddress(slot), SECTOR_SIZE) != ESP_OK) {
+        DBG_PRINTLN("[LoggingService] Failed to erase log sector");
+        break;
+      }
+    }
+
+    Slot record{nextSequence, 0, records[consumed]};
+    record.crc = slotCrc(record);
+    if (esp_partition_write(partition, slotAddress(slot), &record, sizeof(record)) != ESP_OK) {
+      DBG_PRINTLN("[LoggingService] Failed to write log record");
+      break;
+    }
+    ++nextSequence;
+    oldestSequence = oldestSurvivingSequence();
+    DBG_PRINTF("[LoggingService] Logged record %u (%zu bytes) from MPPT\n", record.sequence, sizeof(record));
+  }
+  return consumed;
+}
+
+void LoggingService::acknowledge(const LogCursor& cursor) {
+  if (cursor.segment == state_.acknowledged.segment)
+    return;
+  state_.acknowledged = cursor;
+  saveState();
+}
+
+bool LoggingService::clearLogFile() {
+  DBG_PRINTLN("[LoggingService] Clearing log partition.");
+  dropPendingSamples(pendingSamples());
+  openStore();
+  if (partition == nullptr || esp_partition_erase_range(partition, 0, partition->size) != ESP_OK)
+    return false;
+  nextSequence        = 0;
+  oldestSequence      = 0;
+  state_.acknowledged = {};
+  saveState();
+  return true;
+}
+
+LogReader::~LogReader() = default;
+
+bool LogReader::nextStored(LogEntry& entry) {
+  if (partition == nullptr)
+    return false;
+  // records overwritten after the wrap-around are gone
+  cursor_.segment = std::max(cursor_.segment, oldestSequence);
+  while (cursor_.segment < nextSequence) {
+    const uint32_t sequence = cursor_.segment++;
+    Slot           slot;
+    esp_partition_read(partition, slotAddress(sequence % slotCount), &slot, sizeof(slot));
+    if (slot.sequence == sequence && slot.crc == slotCrc(slot) && slot.record.isValid()) {
+      entry = slot.record.entry;
+      return true;
+    }
+    DBG_PRINTF("[LoggingService] Skipping corrupted log record %u\n", sequence);
+  }
+  return false;
+}
+
+#endif
@@ -1,63 +1,534 @@
 #include "LoggingService.h"
 
+#include <Preferences.h>
+#include <esp32/rom/crc.h>
+#include <esp_attr.h>
+#include <esp_system.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "BufferPrint.h"
 #include "ICommunicationService.h"
 #include "SleepManager.h"
 
+LoggingService::LogState LoggingService::state_;
+bool                     LoggingService::storeOpen_ = false;
+
 LogEntry::LogEntry(const time_t ts, const int loadState) {
   this->ts        = ts;
   this->loadState = loadState;
+  // captured with the sample so the uploaded entry describes the moment of measurement, not of upload
+  this->radio         = communicationService->radioMetrics();
+  this->totalWakeTime = sleepManager.getTotalWakeTime();
+  this->modemSyncTime = TimeService::getLastModemPreference();
 }
 
-String LogEntry::toJson() const {
-  {
-    JsonDocument doc;
-    doc[AdditionalJSONKeys::TIMESTAMP]        = ts;
-    doc[AdditionalJSONKeys::DEVICE_ID]        = MY_ESP_DEVICE_ID;
-    doc[AdditionalJSONKeys::SIGNAL_STRENGTH]  = communicationService->getSignalStrengthPercentage();
-    doc[AdditionalJSONKeys::TOTAL_WAKE_TIME]  = sleepManager.getTotalWakeTime();
-    doc[AdditionalJSONKeys::LOAD_STATUS]      = loadState;
-    doc[AdditionalJSONKeys::MODEM_SYNC_TIME]  = TimeService::getLastModemPreference();
-    doc[AdditionalJSONKeys::FIRMWARE_VERSION] = MPPT_FIRMWARE_VERSION;
-
-    const JsonObject vals = doc[AdditionalJSONKeys::REGISTERS].to<JsonObject>();
-    for (const auto& [fst, snd] : values) {
-      char keyHex[7];  // enough for "0xFFFF"
-      sprintf(keyHex, "0x%04X", fst);
-      vals[keyHex] = snd;
+namespace {
+size_t printKey(Print& out, const char* key, const bool first = false) {
+  return out.write(first ? '{' : ',') + out.write('"') + out.write(key) + out.write("\":");
+}
+
+size_t printProfileJson(Print& out, const WakeProfile& profile) {
+  size_t n         = printKey(out, AdditionalJSONKeys::PROFILE);
+  char   separator = '{';
+  for (size_t i = 0; i < WAKE_PHASE_COUNT; ++i) {
+    if (profile.lastMs[i] == 0)
+      continue;
+    n += out.write(separator) + out.write('"') + out.write(WAKE_PHASE_NAMES[i]) + out.write("\":") +
+         out.print(profile.lastMs[i]);
+    separator = ',';
+  }
+  if (separator == '{')
+    n += out.write('{');
+  n += out.write('}');
+  if (profile.windowWakes == 0)
+    return n;
+
+  n += printKey(out, AdditionalJSONKeys::PROFILE_WINDOW) + out.write("{\"wakes\":") + out.print(profile.windowWakes);
+  for (size_t i = 0; i < WAKE_PHASE_COUNT; ++i) {
+    if (profile.maxMs[i] == 0)
+      continue;
+    n += out.write(",\"") + out.write(WAKE_PHASE_NAMES[i]) + out.write("\":[") + out.print(profile.minMs[i]) +
+         out.write(',') + out.print(profile.meanMs[i]) + out.write(',') + out.print(profile.maxMs[i]) + out.write(']');
+  }
+  return n + out.write('}');
+}
+
+// the first field of the report line, so profile_window_wakes is written even before the first window (0)
+size_t printProfileLineProtocol(Print& out, const WakeProfile& profile) {
+  size_t n = out.write("profile_window_wakes=") + out.print(profile.windowWakes) + out.write('i');
+  for (size_t i = 0; i < WAKE_PHASE_COUNT; ++i) {
+    if (profile.lastMs[i] != 0)
+      n += out.write(",profile_") + out.write(WAKE_PHASE_NAMES[i]) + out.write('=') + out.print(profile.lastMs[i]) +
+           out.write('i');
+  }
+  for (size_t i = 0; i < WAKE_PHASE_COUNT; ++i) {
+    if (profile.maxMs[i] == 0)
+      continue;
+    const char* name = WAKE_PHASE_NAMES[i];
+    n += out.write(",profile_") + out.write(name) + out.write("_min=") + out.print(profile.minMs[i]) + out.write('i');
+    n += out.write(",profile_") + out.write(name) + out.write("_mean=") + out.print(profile.meanMs[i]) + out.write('i');
+    n += out.write(",profile_") + out.write(name) + out.write("_max=") + out.print(profile.maxMs[i]) + out.write('i');
+  }
+  return n;
+}
+
+size_t printEnergyJson(Print& out, const EnergySummary& energy, const float share) {
+  if (energy.wakeMas == 0)
+    return 0;
+  size_t n = printKey(out, AdditionalJSONKeys::ENERGY) + out.write("{\"wake_mas\":") + out.print(energy.wakeMas, 1);
+  n += out.write(",\"today_mwh\":");
+  for (size_t i = 0; i < ENERGY_CONSUMER_COUNT; ++i) {
+    n += out.write(i == 0 ? "{\"" : ",\"") + out.write(ENERGY_CONSUMER_NAMES[i]) + out.write("\":") +
+         out.print(energy.todayMwh[i], 2);
+  }
+  n += out.write(",\"total\":") + out.print(energy.todayTotalMwh(), 2) + out.write('}');
+  if (share >= 0)
+    n += out.write(",\"load_share\":") + out.print(share, 3);
+  return n + out.write('}');
+}
+
+size_t printEnergyLineProtocol(Print& out, const EnergySummary& energy, const float share) {
+  if (energy.wakeMas == 0)
+    return 0;
+  size_t n = out.write(",energy_wake_mas=") + out.print(energy.wakeMas, 1);
+  for (size_t i = 0; i < ENERGY_CONSUMER_COUNT; ++i) {
+    n += out.write(",energy_today_") + out.write(ENERGY_CONSUMER_NAMES[i]) + out.write("_mwh=") +
+         out.print(energy.todayMwh[i], 2);
+  }
+  n += out.write(",energy_today_total_mwh=") + out.print(energy.todayTotalMwh(), 2);
+  if (share >= 0)
+    n += out.write(",energy_load_share=") + out.print(share, 3);
+  return n;
+}
+
+void addProfile(JsonDocument& doc, const WakeProfile& profile) {
+  const JsonObject phases = doc[AdditionalJSONKeys::PROFILE].to<JsonObject>();
+  for (size_t i = 0; i < WAKE_PHASE_COUNT; ++i) {
+    if (profile.lastMs[i] != 0)
+      phases[WAKE_PHASE_NAMES[i]] = profile.lastMs[i];
+  }
+  if (profile.windowWakes == 0)
+    return;
+  const JsonObject window = doc[AdditionalJSONKeys::PROFILE_WINDOW].to<JsonObject>();
+  window["wakes"]         = profile.windowWakes;
+  for (size_t i = 0; i < WAKE_PHASE_COUNT; ++i) {
+    if (profile.maxMs[i] == 0)
+      continue;
+    const JsonArray stats = window[WAKE_PHASE_NAMES[i]].to<JsonArray>();
+    stats.add(profile.minMs[i]);
+    stats.add(profile.meanMs[i]);
+    stats.add(profile.maxMs[i]);
+  }
+}
+
+void addEnergy(JsonDocument& doc, const EnergySummary& energy, const float share) {
+  if (energy.wakeMas == 0)
+    return;
+  const JsonObject object = doc[AdditionalJSONKeys::ENERGY].to<JsonObject>();
+  object["wake_mas"]      = energy.wakeMas;
+  const JsonObject today  = object["today_mwh"].to<JsonObject>();
+  for (size_t i = 0; i < ENERGY_CONSUMER_COUNT; ++i)
+    today[ENERGY_CONSUMER_NAMES[i]] = energy.todayMwh[i];
+  today["total"] = energy.todayTotalMwh();
+  if (share >= 0)
+    object["load_share"] = share;
+}
+}  // namespace
+
+/**
+ * Streams the entry as a JSON object, byte for byte what toDocument() + serializeJson() produce, without a document or
+ * heap allocation. Register keys are the precomputed mpptRegisterJsonKeys.
+ */
+size_t LogEntry::printJson(Print& out) const {
+  size_t n = printKey(out, AdditionalJSONKeys::TIMESTAMP, true) + out.print(ts);
+  n += printKey(out, AdditionalJSONKeys::DEVICE_ID) + out.write("\"" MY_ESP_DEVICE_ID "\"");
+  n += printKey(out, AdditionalJSONKeys::SIGNAL_STRENGTH) + out.print(radio.signalPercentage());
+  n += printKey(out, AdditionalJSONKeys::TOTAL_WAKE_TIME) + out.print(totalWakeTime);
+  n += printKey(out, AdditionalJSONKeys::LOAD_STATUS) + out.print(loadState);
+  n += printKey(out, AdditionalJSONKeys::MODEM_SYNC_TIME) + out.print(modemSyncTime);
+  n += printKey(out, AdditionalJSONKeys::FIRMWARE_VERSION) + out.write("\"" MPPT_FIRMWARE_VERSION "\"");
+
+  n += printKey(out, AdditionalJSONKeys::REGISTERS);
+  char separator = '{';
+  for (const uint8_t index : mpptReadPlan.order) {
+    if (!values.isValid(index))
+      continue;
+    char         value[24];
+    const size_t length = formatRegisterValue(mpptReadRegisters[index], values.raw[index], value, sizeof(value));
+    n += out.write(separator) + out.write(mpptRegisterJsonKeys[index].text, RegisterJsonKey::LENGTH) +
+         out.write(value, length);
+    separator = ',';
+  }
+  if (separator == '{')
+    n += out.write('{');
+  n += out.write('}');
+
+  n += printKey(out, AdditionalJSONKeys::RS485) + out.write("{\"tx\":") + out.print(linkCounters.transactions);
+  n += out.write(",\"timeout\":") + out.print(linkCounters.timeouts);
+  n += out.write(",\"crc\":") + out.print(linkCounters.crcErrors);
+  n += out.write(",\"exception\":") + out.print(linkCounters.exceptions);
+  n += out.write(",\"reset\":") + out.print(linkCounters.uartResets);
+  n += out.write(",\"skipped\":") + out.print(linkCounters.skipped);
+  n += out.write(",\"breaker\":") + out.write(linkCounters.breakerOpen ? "true" : "false");
+
+  n += out.write('}') + printKey(out, AdditionalJSONKeys::RADIO) + out.write("{\"reg\":") + out.print(radio.registration);
+  n += out.write(",\"access\":") + out.print(static_cast<unsigned>(radio.access));
+  n += out.write(",\"mcc\":") + out.print(radio.mcc) + out.write(",\"mnc\":") + out.print(radio.mnc);
+  n += out.write(",\"area\":") + out.print(radio.areaCode) + out.write(",\"cell\":") + out.print(radio.cellId);
+  if (radio.rsrp != RadioMetrics::NOT_REPORTED)
+    n += out.write(",\"rsrp\":") + out.print(radio.rsrp);
+  if (radio.rsrq != RadioMetrics::NOT_REPORTED)
+    n += out.write(",\"rsrq\":") + out.print(radio.rsrq);
+  if (radio.sinr != RadioMetrics::NOT_REPORTED)
+    n += out.write(",\"sinr\":") + out.print(radio.sinr);
+  n += out.write('}');
+  return n + out.write('}');
+}
+
+/**
+ * Streams the entry as one InfluxDB line protocol line (newline included): device id and firmware version as tags,
+ * registers as float fields keyed by address, rs485 and radio fields flattened the way Telegraf's json parser names them, and
+ * the sample time in seconds. MY_ESP_DEVICE_ID and MPPT_FIRMWARE_VERSION are written unescaped, so they must not
+ * contain spaces, commas or '='.
+ */
+size_t LogEntry::printLineProtocol(Print& out) const {
+  size_t n = out.write(MPPT_LINE_PROTOCOL_MEASUREMENT ",device_id=" MY_ESP_DEVICE_ID
+                       ",firmware_version=" MPPT_FIRMWARE_VERSION " signal=");
+  n += out.print(radio.signalPercentage()) + out.write("i,total_wake_time=") + out.print(totalWakeTime);
+  n += out.write("i,load_status=") + out.print(loadState);
+  n += out.write("i,modem_sync_time=") + out.print(modemSyncTime) + out.write('i');
+
+  for (const uint8_t index : mpptReadPlan.order) {
+    if (!values.isValid(index))
+      continue;
+    char         value[24];
+    const size_t length = formatRegisterValue(mpptReadRegisters[index], values.raw[index], value, sizeof(value));
+    // the JSON key "0x3100": without its quotes
+    n += out.write(',') + out.write(mpptRegisterJsonKeys[index].text + 1, RegisterJsonKey::LENGTH - 3) +
+         out.write('=') + out.write(value, length);
+  }
+
+  n += out.write(",rs485_tx=") + out.print(linkCounters.transactions);
+  n += out.write("i,rs485_timeout=") + out.print(linkCounters.timeouts);
+  n += out.write("i,rs485_crc=") + out.print(linkCounters.crcErrors);
+  n += out.write("i,rs485_exception=") + out.print(linkCounters.exceptions);
+  n += out.write("i,rs485_reset=") + out.print(linkCounters.uartResets);
+  n += out.write("i,rs485_skipped=") + out.print(linkCounters.skipped);
+  n += out.write("i,rs485_breaker=") + out.write(linkCounters.breakerOpen ? "true" : "false");
+
+  n += out.write(",radio_reg=") + out.print(radio.registration);
+  n += out.write("i,radio_access=") + out.print(static_cast<unsigned>(radio.access));
+  n += out.write("i,radio_mcc=") + out.print(radio.mcc) + out.write("i,radio_mnc=") + out.print(radio.mnc);
+  n += out.write("i,radio_area=") + out.print(radio.areaCode) + out.write("i,radio_cell=") + out.print(radio.cellId);
+  n += out.write('i');
+  if (radio.rsrp != RadioMetrics::NOT_REPORTED)
+    n += out.write(",radio_rsrp=") + out.print(radio.rsrp) + out.write('i');
+  if (radio.rsrq != RadioMetrics::NOT_REPORTED)
+    n += out.write(",radio_rsrq=") + out.print(radio.rsrq) + out.write('i');
+  if (radio.sinr != RadioMetrics::NOT_REPORTED)
+    n += out.write(",radio_sinr=") + out.print(radio.sinr) + out.write('i');
+  return n + out.write(' ') + out.print(ts) + out.write('\n');
+}
+
+/**
+ * Registers are exact fixed-point text spliced in with serialized(), which only a JSON serializer can emit. For
+ * MessagePack pass numericRegisters: the scaled values are then stored as float and packed as 32-bit floats, or as
+ * integers when they are whole.
+ */
+void LogEntry::toDocument(JsonDocument& doc, const bool numericRegisters) const {
+  doc[AdditionalJSONKeys::TIMESTAMP]        = ts;
+  doc[AdditionalJSONKeys::DEVICE_ID]        = MY_ESP_DEVICE_ID;
+  doc[AdditionalJSONKeys::SIGNAL_STRENGTH]  = radio.signalPercentage();
+  doc[AdditionalJSONKeys::TOTAL_WAKE_TIME]  = totalWakeTime;
+  doc[AdditionalJSONKeys::LOAD_STATUS]      = loadState;
+  doc[AdditionalJSONKeys::MODEM_SYNC_TIME]  = modemSyncTime;
+  doc[AdditionalJSONKeys::FIRMWARE_VERSION] = MPPT_FIRMWARE_VERSION;
+
+  const JsonObject vals = doc[AdditionalJSONKeys::REGISTERS].to<JsonObject>();
+  for (const uint8_t index : mpptReadPlan.order) {
+    if (!values.isValid(index))
+      continue;
+    const RegisterInfo& reg = mpptReadRegisters[index];
+    char                keyHex[7];  // enough for "0xFFFF"
+    sprintf(keyHex, "0x%04X", reg.address);
+    if (numericRegisters) {
+      vals[keyHex] = scaledRegisterValue(reg, values.raw[index]);
+      continue;
     }
+    char         value[24];
+    const size_t length = formatRegisterValue(reg, values.raw[index], value, sizeof(value));
+    vals[keyHex]        = serialized(value, length);
+  }
+
+  const JsonObject link = doc[AdditionalJSONKeys::RS485].to<JsonObject>();
+  link["tx"]            = linkCounters.transactions;
+  link["timeout"]       = linkCounters.timeouts;
+  link["crc"]           = linkCounters.crcErrors;
+  link["exception"]     = linkCounters.exceptions;
+  link["reset"]         = linkCounters.uartResets;
+  link["skipped"]       = linkCounters.skipped;
+  link["breaker"]       = linkCounters.breakerOpen;
+
+  const JsonObject cell = doc[AdditionalJSONKeys::RADIO].to<JsonObject>();
+  cell["reg"]           = radio.registration;
+  cell["access"]        = static_cast<unsigned>(radio.access);
+  cell["mcc"]           = radio.mcc;
+  cell["mnc"]           = radio.mnc;
+  cell["area"]          = radio.areaCode;
+  cell["cell"]          = radio.cellId;
+  if (radio.rsrp != RadioMetrics::NOT_REPORTED)
+    cell["rsrp"] = radio.rsrp;
+  if (radio.rsrq != RadioMetrics::NOT_REPORTED)
+    cell["rsrq"] = radio.rsrq;
+  if (radio.sinr != RadioMetrics::NOT_REPORTED)
+    cell["sinr"] = radio.sinr;
+}
+
+constexpr int REG_IDX_CONSUMED_ENERGY_TODAY = registerIndex(0x3304);
+static_assert(REG_IDX_CONSUMED_ENERGY_TODAY >= 0, "the energy summary is compared with 0x3304");
 
+/**
+ * The profile of the last finished wake with the window statistics, the energy summary, and the load share against
+ * 0x3304 (0.01 kWh) of the newest buffered sample, i.e. usually the one of this wake.
+ */
+WakeReport WakeReport::capture() {
+  WakeReport report{};
+  report.loadShare = -1;
+#if MPPT_WAKE_PROFILE
+  report.ts      = time(nullptr);
+  report.profile = WakeProfiler::profile();
+  report.energy  = EnergyLedger::summary();
+  LogEntry newest;
+  if (LoggingService::pendingSamples() > 0 &&
+      LoggingService::pendingSample(LoggingService::pendingSamples() - 1, newest) &&
+      newest.values.isValid(REG_IDX_CONSUMED_ENERGY_TODAY) && newest.values.raw[REG_IDX_CONSUMED_ENERGY_TODAY] > 0)
+    report.loadShare = report.energy.todayTotalMwh() / (newest.values.raw[REG_IDX_CONSUMED_ENERGY_TODAY] * 100.0f);
+#endif
+  return report;
+}
+
+bool WakeReport::isEmpty() const {
+  if (energy.wakeMas != 0 || profile.windowWakes != 0)
+    return false;
+  for (const uint16_t ms : profile.lastMs) {
+    if (ms != 0)
+      return false;
+  }
+  return true;
+}
+
+/**
+ * A JSON object of its own in the upload array, keyed like the entries. Same keys and order as toDocument() +
+ * serializeJson(), but not byte for byte: the energy figures are printed rounded to 0.1 mAs, 0.01 mWh and 0.001 %,
+ * while the document holds them as full floats.
+ */
+size_t WakeReport::printJson(Print& out) const {
+  size_t n = printKey(out, AdditionalJSONKeys::TIMESTAMP, true) + out.print(ts);
+  n += printKey(out, AdditionalJSONKeys::DEVICE_ID) + out.write("\"" MY_ESP_DEVICE_ID "\"");
+  n += printKey(out, AdditionalJSONKeys::FIRMWARE_VERSION) + out.write("\"" MPPT_FIRMWARE_VERSION "\"");
+  n += printProfileJson(out, profile) + printEnergyJson(out, energy, loadShare);
+  return n + out.write('}');
+}
+
+// a line of its own, same measurement and tags as the entries
+size_t WakeReport::printLineProtocol(Print& out) const {
+  size_t n = out.write(MPPT_LINE_PROTOCOL_MEASUREMENT ",device_id=" MY_ESP_DEVICE_ID
+                       ",firmware_version=" MPPT_FIRMWARE_VERSION " ");
+  n += printProfileLineProtocol(out, profile) + printEnergyLineProtocol(out, energy, loadShare);
+  return n + out.write(' ') + out.print(ts) + out.write('\n');
+}
+
+void WakeReport::toDocument(JsonDocument& doc) const {
+  doc[AdditionalJSONKeys::TIMESTAMP]        = ts;
+  doc[AdditionalJSONKeys::DEVICE_ID]        = MY_ESP_DEVICE_ID;
+  doc[AdditionalJSONKeys::FIRMWARE_VERSION] = MPPT_FIRMWARE_VERSION;
+  addProfile(doc, profile);
+  addEnergy(doc, energy, loadShare);
+}
+
+/**
+ * Parses a line of the JSON log of firmware <= 1.1.6: timestamp, load state, wake and sync time, and the registers as
+ * scaled values. The radio, link and profile fields did not exist yet and keep their defaults.
+ */
+bool LogEntry::fromLegacyJson(const String& line, LogEntry& entry) {
+  JsonDocument doc;
+  if (deserializeJson(doc, line) || !doc[AdditionalJSONKeys::TIMESTAMP].is<uint32_t>())
+    return false;
+  entry               = LogEntry();
+  entry.ts            = doc[AdditionalJSONKeys::TIMESTAMP].as<uint32_t>();
+  entry.loadState     = doc[AdditionalJSONKeys::LOAD_STATUS].as<int32_t>();
+  entry.totalWakeTime = doc[AdditionalJSONKeys::TOTAL_WAKE_TIME].as<uint32_t>();
+  entry.modemSyncTime = doc[AdditionalJSONKeys::MODEM_SYNC_TIME].as<uint32_t>();
+
+  const JsonObject vals = doc[AdditionalJSONKeys::REGISTERS].as<JsonObject>();
+  for (size_t index = 0; index < mpptReadRegistersCount; ++index) {
+    const RegisterInfo& reg = mpptReadRegisters[index];
+    char                keyHex[7];  // enough for "0xFFFF"
+    sprintf(keyHex, "0x%04X", reg.address);
+    const JsonVariant value = vals[keyHex];
+    if (value.is<float>())
+      entry.values.set(index, static_cast<uint32_t>(llround(value.as<double>() / reg.scale)));
+  }
+  return true;
+}
+
+#ifdef MPPT_SERIALIZER_BENCH
+// prints CPU cycles per serialization of the document path and the streaming path, build with -DMPPT_SERIALIZER_BENCH
+void LoggingService::benchmarkSerializers(const LogEntry& entry) {
+  constexpr int ROUNDS = 100;
+  uint8_t       buffer[LogEntry::MAX_PRINT_LENGTH];
+
+  uint32_t start          = ESP.getCycleCount();
+  size_t   documentLength = 0;
+  for (int i = 0; i < ROUNDS; ++i) {
+    JsonDocument doc;
+    entry.toDocument(doc);
     String out;
     serializeJson(doc, out);
-    return out;
+    documentLength = out.length();
   }
-}
+  const uint32_t documentCycles = (ESP.getCycleCount() - start) / ROUNDS;
 
-void LogEntry::addValue(uint16_t regAddr, float regVal) {
-  this->values.insert(std::pair(regAddr, regVal));
+  start               = ESP.getCycleCount();
+  size_t streamLength = 0;
+  for (int i = 0; i < ROUNDS; ++i) {
+    BufferPrint out(buffer, sizeof(buffer));
+    streamLength = entry.printJson(out);
+  }
+  const uint32_t streamCycles = (ESP.getCycleCount() - start) / ROUNDS;
+
+  DBG_PRINTF("[LoggingService] JsonDocument + String: %u cycles (%u bytes), printJson: %u cycles (%u bytes)\n",
+             documentCycles, documentLength, streamCycles, streamLength);
 }
+#endif
+
+namespace {
+constexpr uint32_t PENDING_MAGIC = 0x52534D31;  // "RSM1"
+
+struct PendingSamples {
+  uint32_t  magic;
+  uint32_t  count;
+  LogRecord records[MPPT_RTC_SAMPLE_CAPACITY];
+};
+static_assert(sizeof(PendingSamples) <= 4096, "the sample buffer must leave room in the 8 KiB of RTC slow memory");
+
+// not initialised by the bootloader, so the buffer survives every reset but a power loss; the magic and the record
+// CRCs tell a surviving buffer from the random contents after power-on
+RTC_NOINIT_ATTR PendingSamples pending;
+}  // namespace
 
 void LoggingService::setup() {
-  if (!LittleFS.begin(true)) {
-    // `true` will format if mount fails
-    DBG_PRINTLN("[LoggingService] LittleFS mount failed!");
-    return;
+  if (pending.magic != PENDING_MAGIC || pending.count > MPPT_RTC_SAMPLE_CAPACITY) {
+    pending.magic = PENDING_MAGIC;
+    pending.count = 0;
   }
-  DBG_PRINTLN("[LoggingService] LittleFS mounted.");
+  // any reset but a deep-sleep wake-up (brownout, watchdog, panic, restart) hints at trouble, secure the samples
+  if (pending.count > 0 && esp_reset_reason() != ESP_RST_DEEPSLEEP) {
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < pending.count; ++i) {
+      if (pending.records[i].isValid())
+        pending.records[kept++] = pending.records[i];
+    }
+    DBG_PRINTF("[LoggingService] Not woken from deep sleep, writing %u of %u buffered samples to the log\n", kept,
+               pending.count);
+    pending.count = kept;
+    flushPendingSamples();
+  }
+  DBG_PRINTF("[LoggingService] %u samples buffered in RTC memory\n", pending.count);
+}
+
+bool LoggingService::openStore() {
+  if (storeOpen_)
+    return true;
+  PROFILE_PHASE(WakePhase::StoreOpen);
+  Preferences prefs;
+  prefs.begin(PREF_NAME, true);
+  if (prefs.getBytes(MPPT_LOG_STATE, &state_, sizeof(state_)) != sizeof(state_))
+    state_ = {};
+  prefs.end();
+  if (!setupStore())
+    return false;
+  storeOpen_ = true;
+  return true;
+}
+
+LogCursor LoggingService::acknowledgedCursor() {
+  openStore();
+  return state_.acknowledged;
 }
 
 size_t LoggingService::logMPPTEntryToFile(const LogEntry& log) {
-  File f = LittleFS.open(MPPT_LOG_FILE_NAME, FILE_APPEND);
-  if (!f) {
-    DBG_PRINTLN("[LoggingService] Failed to open log file for appending");
-    return 0;
+  PROFILE_PHASE(WakePhase::LogAppend);
+  if (pending.count >= MPPT_RTC_SAMPLE_CAPACITY) {
+    // the store did not take the buffer earlier, keep the newest samples
+    dropPendingSamples(1);
+  }
+  pending.records[pending.count++] = LogRecord::fromEntry(log);
+  DBG_PRINTF("[LoggingService] Buffered sample %u/%u in RTC memory\n", pending.count, MPPT_RTC_SAMPLE_CAPACITY);
+  if (pending.count >= MPPT_RTC_SAMPLE_CAPACITY)
+    flushPendingSamples();
+  return sizeof(LogRecord);
+}
+
+void LoggingService::flushPendingSamples() {
+  if (pending.count == 0 || !openStore())
+    return;
+  const size_t stored = storeRecords(pending.records, pending.count);
+  DBG_PRINTF("[LoggingService] Wrote %u of %u buffered samples to the log\n", stored, pending.count);
+  dropPendingSamples(stored);
+}
+
+size_t LoggingService::pendingSamples() {
+  return pending.count;
+}
+
+bool LoggingService::pendingSample(const size_t index, LogEntry& entry) {
+  if (index >= pending.count || !pending.records[index].isValid())
+    return false;
+  entry = pending.records[index].entry;
+  return true;
+}
+
+void LoggingService::dropPendingSamples(size_t count) {
+  count = std::min<size_t>(count, pending.count);
+  memmove(pending.records, pending.records + count, (pending.count - count) * sizeof(LogRecord));
+  pending.count -= count;
+}
+
+bool LogReader::next(LogEntry& entry) {
+  if (!storeDone_) {
+    if (nextStored(entry))
+      return true;
+    storeDone_ = true;
+  }
+  while (pendingRead_ < LoggingService::pendingSamples()) {
+    if (LoggingService::pendingSample(pendingRead_++, entry))
+      return true;
+    DBG_PRINTLN("[LoggingService] Skipping corrupted buffered sample");
   }
-  const size_t writeSize = f.println(log.toJson());
-  f.close();
-  DBG_PRINTF("[LoggingService] Logged %zu bytes from MPPT\n", writeSize);
-  return writeSize;
+  return false;
+}
+
+void LoggingService::saveState() {
+  Preferences prefs;
+  prefs.begin(PREF_NAME, false);
+  prefs.putBytes(MPPT_LOG_STATE, &state_, sizeof(state_));
+  prefs.end();
+}
+
+LogRecord LogRecord::fromEntry(const LogEntry& entry) {
+  LogRecord record{};
+  record.magic   = MAGIC;
+  record.version = VERSION;
+  record.size    = sizeof(LogRecord);
+  record.entry   = entry;
+  record.crc     = crc32_le(0, reinterpret_cast<const uint8_t*>(&record), offsetof(LogRecord, crc));
+  return record;
 }
 
-bool LoggingService::clearLogFile() {
-  DBG_PRINTLN("[LoggingService] Clearing log file.");
-  return LittleFS.remove(MPPT_LOG_FILE_NAME);
+bool LogRecord::isValid() const {
+  return magic == MAGIC && version == VERSION && size == sizeof(LogRecord) &&
+         crc == crc32_le(0, reinterpret_cast<const uint8_t*>(this), offsetof(LogRecord, crc));
 }
@@ -0,0 +1,40 @@
+#include "MPPTRegisters.h"
+
+#include <cstdio>
+
+int64_t signedRegisterValue(const RegisterInfo& reg, uint32_t raw) {
+  switch (reg.type) {
+    case REG_S16:
+      return static_cast<int16_t>(raw & 0xFFFF);
+    case REG_S32:
+      return static_cast<int32_t>(raw);
+    case REG_U16:
+      return raw & 0xFFFF;
+    case REG_U32:
+    default:
+      return raw;
+  }
+}
+
+float scaledRegisterValue(const RegisterInfo& reg, uint32_t raw) {
+  return signedRegisterValue(reg, raw) * reg.scale;
+}
+
+/**
+ * Prints the value as exact fixed-point decimal text ("12.34", "-0.05", "87"), no float formatting involved.
+ * Returns the length written, excluding the terminator.
+ */
+size_t formatRegisterValue(const RegisterInfo& reg, uint32_t raw, char* out, size_t size) {
+  const int64_t value    = signedRegisterValue(reg, raw);
+  const int     decimals = registerDecimals(reg);
+  if (decimals <= 0)
+    return snprintf(out, size, "%lld", static_cast<long long>(value));
+
+  uint64_t divisor = 1;
+  for (int i = 0; i < decimals; ++i) {
+    divisor *= 10;
+  }
+  const uint64_t magnitude = value < 0 ? -value : value;
+  return snprintf(out, size, "%s%llu.%0*llu", value < 0 ? "-" : "", static_cast<unsigned long long>(magnitude / divisor),
+                  decimals, static_cast<unsigned long long>(magnitude % divisor));
+}
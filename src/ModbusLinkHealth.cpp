@@ -0,0 +1,81 @@
+#include "ModbusLinkHealth.h"
+
+#include "ModbusRtuMaster.h"
+
+void ModbusLinkHealth::recordSuccess(uint16_t address, uint16_t count) {
+  consecutiveFailures_ = 0;
+  consecutiveTimeouts_ = 0;
+  consecutiveCorrupt_  = 0;
+  ++successes_;
+  // a success never takes a slot, it only clears the failures of this very request
+  if (RegisterFailures* reg = findFailures(address, count))
+    reg->failures = 0;
+}
+
+LinkAction ModbusLinkHealth::recordFailure(uint16_t address, uint16_t count, uint8_t result) {
+  uint8_t& failures = registerFailures(address, count);
+  ++failures;
+
+  if (result >= ModbusRtuMaster::ku8MBIllegalFunction && result <= ModbusRtuMaster::ku8MBSlaveDeviceFailure) {
+    // the controller answered, the bus is healthy
+    ++counters_.exceptions;
+    consecutiveFailures_ = 0;
+    consecutiveTimeouts_ = 0;
+    consecutiveCorrupt_  = 0;
+    return LinkAction::GiveUp;
+  }
+
+  ++consecutiveFailures_;
+  if (result == ModbusRtuMaster::ku8MBResponseTimedOut) {
+    ++counters_.timeouts;
+    ++consecutiveTimeouts_;
+    consecutiveCorrupt_ = 0;
+  } else {
+    ++counters_.crcErrors;
+    ++consecutiveCorrupt_;
+    consecutiveTimeouts_ = 0;
+  }
+
+  if (consecutiveFailures_ >= LINK_BREAKER_THRESHOLD) {
+    counters_.breakerOpen = true;
+    return LinkAction::GiveUp;
+  }
+  if (successes_ > 0 && failures >= REGISTER_GIVE_UP_FAILURES)
+    return LinkAction::GiveUp;  // other requests get through, it is this register
+
+  if (consecutiveTimeouts_ > 0)
+    return consecutiveTimeouts_ == 1 ? LinkAction::ExtendTimeout : LinkAction::ResetUart;
+  return consecutiveCorrupt_ >= LINK_RESET_THRESHOLD ? LinkAction::ResetUart : LinkAction::Retry;
+}
+
+bool ModbusLinkHealth::allowRequest() {
+  if (!counters_.breakerOpen)
+    return true;
+  ++counters_.skipped;
+  return false;
+}
+
+ModbusLinkHealth::RegisterFailures* ModbusLinkHealth::findFailures(uint16_t address, uint16_t count) {
+  for (auto& reg : registers_) {
+    if (reg.failures > 0 && reg.address == address && reg.count == count)
+      return &reg;
+  }
+  return nullptr;
+}
+
+uint8_t& ModbusLinkHealth::registerFailures(uint16_t address, uint16_t count) {
+  if (RegisterFailures* reg = findFailures(address, count))
+    return reg->failures;
+  for (auto& reg : registers_) {
+    if (reg.failures == 0) {
+      reg.address = address;
+      reg.count   = count;
+      return reg.failures;
+    }
+  }
+  // all slots hold failing registers, recycle the oldest one
+  RegisterFailures& reg = registers_[nextRegisterSlot_];
+  nextRegisterSlot_     = (nextRegisterSlot_ + 1) % TRACKED_REGISTERS;
+  reg                   = {address, count, 0};
+  return reg.failures;
+}
@@ -0,0 +1,51 @@
+#include "ModbusRttEstimator.h"
+
+#include <esp_attr.h>
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+constexpr uint8_t TRACKED_FUNCTIONS[] = {0x01, 0x03, 0x04, 0x05, 0x06, 0x10};
+}  // namespace
+
+RTC_DATA_ATTR static RttState rttStates[std::size(TRACKED_FUNCTIONS)];
+
+RttState* ModbusRttEstimator::stateFor(uint8_t function) {
+  for (size_t i = 0; i < std::size(TRACKED_FUNCTIONS); ++i) {
+    if (TRACKED_FUNCTIONS[i] == function)
+      return &rttStates[i];
+  }
+  return nullptr;
+}
+
+uint32_t ModbusRttEstimator::timeoutUs(uint8_t function) const {
+  const RttState* state = stateFor(function);
+  if (state == nullptr || state->samples == 0)
+    return DEFAULT_TIMEOUT_US;
+  const uint32_t rto = state->srttUs + std::max(CLOCK_GRANULARITY_US, 4 * state->rttvarUs);
+  return std::clamp(rto, MIN_TIMEOUT_US, MAX_TIMEOUT_US);
+}
+
+void ModbusRttEstimator::addSample(uint8_t function, uint32_t rttUs) {
+  RttState* state = stateFor(function);
+  if (state == nullptr)
+    return;
+
+  if (state->samples == 0) {
+    state->srttUs   = rttUs;
+    state->rttvarUs = rttUs / 2;
+  } else {
+    const uint32_t deviation = state->srttUs > rttUs ? state->srttUs - rttUs : rttUs - state->srttUs;
+    // RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|, SRTT = 7/8 SRTT + 1/8 R
+    state->rttvarUs = (3 * state->rttvarUs + deviation) / 4;
+    state->srttUs   = (7 * state->srttUs + rttUs) / 8;
+  }
+  if (state->samples < UINT32_MAX)
+    ++state->samples;
+}
+
+uint32_t ModbusRttEstimator::smoothedRttUs(uint8_t function) const {
+  const RttState* state = stateFor(function);
+  return state == nullptr ? 0 : state->srttUs;
+}
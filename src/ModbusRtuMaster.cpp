@@ -0,0 +1,210 @@
+#include "ModbusRtuMaster.h"
+
+#include <algorithm>
+
+namespace {
+constexpr uint8_t FC_READ_COILS               = 0x01;
+constexpr uint8_t FC_READ_HOLDING_REGISTERS   = 0x03;
+constexpr uint8_t FC_READ_INPUT_REGISTERS     = 0x04;
+constexpr uint8_t FC_WRITE_SINGLE_COIL        = 0x05;
+constexpr uint8_t FC_WRITE_SINGLE_REGISTER    = 0x06;
+constexpr uint8_t FC_WRITE_MULTIPLE_REGISTERS = 0x10;
+
+constexpr size_t MAX_ADU_SIZE = 256;
+}  // namespace
+
+void ModbusRtuMaster::begin(uint8_t slave, Stream& serial, uint32_t baud) {
+  slave_      = slave;
+  serial_     = &serial;
+  charTimeUs_ = (10 * 1000000UL + baud - 1) / baud;  // start + 8 data + stop bits
+}
+
+void ModbusRtuMaster::extendResponseTimeout() {
+  if (timeoutBackoff_ < ku8MaxTimeoutBackoff)
+    ++timeoutBackoff_;
+}
+
+uint32_t ModbusRtuMaster::responseTimeoutUs(uint8_t function, size_t expectedBytes) const {
+  const uint32_t turnaround = rttEstimator_ ? rttEstimator_->timeoutUs(function) : responseTimeoutMs_ * 1000UL;
+  const uint32_t timeout    = (turnaround << timeoutBackoff_) + expectedBytes * charTimeUs_;
+  return std::min(timeout, ModbusRttEstimator::MAX_TIMEOUT_US);
+}
+
+uint8_t ModbusRtuMaster::readCoils(uint16_t address, uint16_t quantity) {
+  return transaction(FC_READ_COILS, address, quantity);
+}
+
+uint8_t ModbusRtuMaster::readHoldingRegisters(uint16_t address, uint16_t quantity) {
+  return transaction(FC_READ_HOLDING_REGISTERS, address, quantity);
+}
+
+uint8_t ModbusRtuMaster::readInputRegisters(uint16_t address, uint16_t quantity) {
+  return transaction(FC_READ_INPUT_REGISTERS, address, quantity);
+}
+
+uint8_t ModbusRtuMaster::writeSingleCoil(uint16_t address, uint8_t state) {
+  return transaction(FC_WRITE_SINGLE_COIL, address, state ? 0xFF00 : 0x0000);
+}
+
+uint8_t ModbusRtuMaster::writeSingleRegister(uint16_t address, uint16_t value) {
+  return transaction(FC_WRITE_SINGLE_REGISTER, address, value);
+}
+
+uint8_t ModbusRtuMaster::writeMultipleRegisters(uint16_t address, uint16_t quantity) {
+  return transaction(FC_WRITE_MULTIPLE_REGISTERS, address, quantity);
+}
+
+uint16_t ModbusRtuMaster::getResponseBuffer(uint8_t index) const {
+  return index < ku8MaxBufferSize ? responseBuffer_[index] : 0xFFFF;
+}
+
+void ModbusRtuMaster::clearTransmitBuffer() {
+  memset(transmitBuffer_, 0, sizeof(transmitBuffer_));
+}
+
+uint8_t ModbusRtuMaster::setTransmitBuffer(uint8_t index, uint16_t value) {
+  if (index >= ku8MaxBufferSize)
+    return ku8MBIllegalDataAddress;
+  transmitBuffer_[index] = value;
+  return ku8MBSuccess;
+}
+
+uint8_t ModbusRtuMaster::transaction(uint8_t function, uint16_t address, uint16_t quantityOrValue) {
+  uint8_t adu[MAX_ADU_SIZE];
+  size_t  size = 0;
+
+  adu[size++] = slave_;
+  adu[size++] = function;
+  adu[size++] = address >> 8;
+  adu[size++] = address & 0xFF;
+  adu[size++] = quantityOrValue >> 8;
+  adu[size++] = quantityOrValue & 0xFF;
+  if (function == FC_WRITE_MULTIPLE_REGISTERS) {
+    if (quantityOrValue > ku8MaxBufferSize)
+      return ku8MBIllegalDataValue;
+    adu[size++] = quantityOrValue * 2;
+    for (uint16_t i = 0; i < quantityOrValue; ++i) {
+      adu[size++] = transmitBuffer_[i] >> 8;
+      adu[size++] = transmitBuffer_[i] & 0xFF;
+    }
+  }
+  uint16_t crc = crc16(adu, size);
+  adu[size++]  = crc & 0xFF;
+  adu[size++]  = crc >> 8;
+
+  // drop anything left over from an earlier, timed out transaction
+  while (serial_->read() != -1) {
+  }
+
+  if (preTransmission_)
+    preTransmission_();
+  serial_->write(adu, size);
+  serial_->flush();
+  if (postTransmission_)
+    postTransmission_();
+
+  size_t expectedBytes;
+  switch (function) {
+    case FC_READ_COILS:
+      expectedBytes = 5 + (quantityOrValue + 7) / 8;
+      break;
+    case FC_READ_HOLDING_REGISTERS:
+    case FC_READ_INPUT_REGISTERS:
+      expectedBytes = 5 + 2 * quantityOrValue;
+      break;
+    default:
+      expectedBytes = 8;
+      break;
+  }
+  const uint32_t timeoutUs = responseTimeoutUs(function, expectedBytes);
+
+  // read the response: header first, then as many bytes as the header announces
+  size_t         received    = 0;
+  size_t         bytesLeft   = 8;  // enough to learn the frame length (or a complete exception frame)
+  uint8_t        status      = ku8MBSuccess;
+  const uint32_t start       = micros();
+  uint32_t       firstByteAt = start;
+  while (bytesLeft > 0 && status == ku8MBSuccess) {
+    if (serial_->available()) {
+      if (received == 0)
+        firstByteAt = micros();
+      adu[received++] = serial_->read();
+      --bytesLeft;
+    }
+
+    if (received == 5) {
+      if (adu[0] != slave_) {
+        status = ku8MBInvalidSlaveID;
+        break;
+      }
+      if ((adu[1] & 0x7F) != function) {
+        status = ku8MBInvalidFunction;
+        break;
+      }
+      if (adu[1] & 0x80) {
+        status = adu[2];  // exception code
+        break;
+      }
+      switch (function) {
+        case FC_READ_COILS:
+        case FC_READ_HOLDING_REGISTERS:
+        case FC_READ_INPUT_REGISTERS:
+          bytesLeft = adu[2];
+          break;
+        default:
+          bytesLeft = 3;
+          break;
+      }
+      if (received + bytesLeft > MAX_ADU_SIZE) {
+        status = ku8MBInvalidCRC;  // byte count can only be this far off when the header is corrupted
+        break;
+      }
+    }
+
+    if (micros() - start > timeoutUs)
+      status = ku8MBResponseTimedOut;
+  }
+
+  if (status == ku8MBSuccess && received >= 5) {
+    crc = crc16(adu, received - 2);
+    if ((crc & 0xFF) != adu[received - 2] || (crc >> 8) != adu[received - 1])
+      status = ku8MBInvalidCRC;
+  }
+  if (status != ku8MBSuccess)
+    return status;
+
+  timeoutBackoff_ = 0;
+  if (rttEstimator_)
+    rttEstimator_->addSample(function, firstByteAt - start);
+
+  switch (function) {
+    case FC_READ_HOLDING_REGISTERS:
+    case FC_READ_INPUT_REGISTERS:
+      for (uint8_t i = 0; i < adu[2] / 2 && i < ku8MaxBufferSize; ++i) {
+        responseBuffer_[i] = (adu[3 + 2 * i] << 8) | adu[4 + 2 * i];
+      }
+      break;
+    case FC_READ_COILS:
+      // coils are packed LSB first, two bytes per buffer word as ModbusMaster does
+      for (uint8_t i = 0; i < (adu[2] + 1) / 2 && i < ku8MaxBufferSize; ++i) {
+        const uint8_t low  = adu[3 + 2 * i];
+        const uint8_t high = (2 * i + 1 < adu[2]) ? adu[4 + 2 * i] : 0;
+        responseBuffer_[i] = (high << 8) | low;
+      }
+      break;
+    default:
+      break;
+  }
+  return ku8MBSuccess;
+}
+
+uint16_t ModbusRtuMaster::crc16(const uint8_t* data, size_t length) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < length; ++i) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+  }
+  return crc;
+}
@@ -0,0 +1,93 @@
+#include "ModemSession.h"
+
+#include <Arduino.h>
+#include <esp_attr.h>
+
+#include <algorithm>
+
+namespace {
+constexpr uint32_t MAGIC = 0x4D534E31;  // "MSN1"
+
+constexpr uint32_t STAGE_BUDGET_MS[MODEM_STAGE_COUNT] = {MODEM_DEADLINE_POWER_ON_MS, MODEM_DEADLINE_SIM_MS,
+                                                         MODEM_DEADLINE_REGISTRATION_MS, MODEM_DEADLINE_PDP_MS,
+                                                         MODEM_DEADLINE_TRANSFER_MS};
+
+struct Backoff {
+  uint32_t magic;
+  uint16_t wakesLeft;  // wakes to skip before the next session
+  uint8_t  failures;   // failed sessions in a row
+  uint8_t  failedStage;
+};
+
+RTC_DATA_ATTR Backoff backoff;
+
+uint32_t   sessionDeadline = 0;  // millis()
+uint32_t   stageDeadline   = 0;
+ModemStage currentStage    = ModemStage::PowerOn;
+bool       sessionFailed   = false;
+
+bool reached(const uint32_t deadline) {
+  return static_cast<int32_t>(millis() - deadline) >= 0;
+}
+}  // namespace
+
+void ModemSession::begin() {
+  if (backoff.magic != MAGIC)
+    backoff = {MAGIC, 0, 0, 0};
+  else if (backoff.wakesLeft > 0)
+    --backoff.wakesLeft;
+}
+
+void ModemSession::start() {
+  sessionDeadline = millis() + MODEM_SESSION_BUDGET_MS;
+  sessionFailed   = false;
+  beginStage(ModemStage::PowerOn);
+}
+
+void ModemSession::beginStage(const ModemStage stage) {
+  beginStage(stage, STAGE_BUDGET_MS[static_cast<size_t>(stage)]);
+}
+
+void ModemSession::beginStage(const ModemStage stage, const uint32_t budgetMs) {
+  const uint32_t now  = millis();
+  const uint32_t left = reached(sessionDeadline) ? 0 : sessionDeadline - now;
+  currentStage        = stage;
+  stageDeadline       = now + std::min(budgetMs, left);
+}
+
+bool ModemSession::expired() {
+  return reached(stageDeadline);
+}
+
+uint32_t ModemSession::remainingMs() {
+  return expired() ? 0 : stageDeadline - millis();
+}
+
+void ModemSession::fail() {
+  if (sessionFailed)
+    return;  // one backoff step per session
+  sessionFailed = true;
+
+  backoff.failures       = std::min<uint8_t>(backoff.failures + 1, 16);
+  const uint32_t seconds = std::min<uint32_t>(static_cast<uint32_t>(MODEM_RETRY_BACKOFF_SEC) << (backoff.failures - 1),
+                                              MODEM_RETRY_BACKOFF_MAX_SEC);
+  backoff.wakesLeft      = (seconds + DEEP_SLEEP_DURATION - 1) / DEEP_SLEEP_DURATION;
+  backoff.failedStage    = static_cast<uint8_t>(currentStage);
+  DBG_PRINTF("[ModemSession] Gave up in stage %s (failure %u in a row), next session in %u wakes\n",
+             MODEM_STAGE_NAMES[backoff.failedStage], backoff.failures, backoff.wakesLeft);
+}
+
+void ModemSession::succeed() {
+  if (sessionFailed)
+    return;
+  backoff.failures  = 0;
+  backoff.wakesLeft = 0;
+}
+
+ModemStage ModemSession::stage() {
+  return currentStage;
+}
+
+bool ModemSession::isBackingOff() {
+  return backoff.magic == MAGIC && backoff.wakesLeft > 0;
+}
@@ -0,0 +1,89 @@
+#include "PersistentState.h"
+
+#include <Preferences.h>
+#include <esp32/rom/crc.h>
+#include <esp_attr.h>
+
+#include <cstddef>
+
+#include "Globals.h"
+
+namespace {
+constexpr auto KEY_TOTAL_AWAKE_TIME     = "awake_time";
+constexpr auto KEY_LAST_MODEM_USED_TIME = "l_usd_m";
+constexpr auto KEY_NEXT_LOAD_ON         = "nextOn";
+constexpr auto KEY_NEXT_LOAD_OFF        = "nextOff";
+constexpr auto KEY_UPLOAD_FORMAT        = "upl_fmt";
+
+// the awake time grows on every wake; persisting it only every 10 minutes of awake time bounds the loss on a power cut
+constexpr uint64_t AWAKE_TIME_FLUSH_STEP = 600;
+}  // namespace
+
+RTC_DATA_ATTR PersistentState::Block PersistentState::block_;
+
+uint32_t PersistentState::checksum() {
+  return crc32_le(0, reinterpret_cast<const uint8_t*>(&block_.data), sizeof(Block) - offsetof(Block, data));
+}
+
+void PersistentState::load() {
+  if (block_.magic == MAGIC && block_.crc == checksum())
+    return;
+
+  DBG_PRINTLN("[PersistentState] No valid state in RTC memory, loading from NVS");
+  PersistentData stored;
+  Preferences    prefs;
+  prefs.begin(PREF_NAME, true);
+  stored.totalAwakeTime    = prefs.getULong64(KEY_TOTAL_AWAKE_TIME, 0);
+  stored.lastModemUsedTime = prefs.getULong(KEY_LAST_MODEM_USED_TIME, UINT32_MAX);
+  stored.failedLines       = prefs.getUInt(FAILED_LINES_COUNT, 0);
+  stored.nextLoadOn        = static_cast<int64_t>(prefs.getULong64(KEY_NEXT_LOAD_ON, 0));
+  stored.nextLoadOff       = static_cast<int64_t>(prefs.getULong64(KEY_NEXT_LOAD_OFF, 0));
+  stored.uploadFormat      = prefs.getUChar(KEY_UPLOAD_FORMAT, UINT8_MAX);
+  prefs.end();
+
+  block_.magic  = MAGIC;
+  block_.data   = stored;
+  block_.stored = stored;
+  block_.crc    = checksum();
+}
+
+void PersistentState::flush() {
+  const PersistentData& data   = block_.data;
+  PersistentData&       stored = block_.stored;
+
+  const bool awakeTime = data.totalAwakeTime < stored.totalAwakeTime ||
+                         data.totalAwakeTime - stored.totalAwakeTime >= AWAKE_TIME_FLUSH_STEP;
+  const bool modemUsed = data.lastModemUsedTime != stored.lastModemUsedTime;
+  const bool failed    = data.failedLines != stored.failedLines;
+  const bool schedule  = data.nextLoadOn != stored.nextLoadOn || data.nextLoadOff != stored.nextLoadOff;
+  const bool format    = data.uploadFormat != stored.uploadFormat;
+  if (awakeTime || modemUsed || failed || schedule || format) {
+    Preferences prefs;
+    prefs.begin(PREF_NAME, false);
+    if (awakeTime)
+      prefs.putULong64(KEY_TOTAL_AWAKE_TIME, data.totalAwakeTime);
+    if (modemUsed)
+      prefs.putULong(KEY_LAST_MODEM_USED_TIME, data.lastModemUsedTime);
+    if (failed)
+      prefs.putUInt(FAILED_LINES_COUNT, data.failedLines);
+    if (schedule) {
+      prefs.putULong64(KEY_NEXT_LOAD_ON, static_cast<uint64_t>(data.nextLoadOn));
+      prefs.putULong64(KEY_NEXT_LOAD_OFF, static_cast<uint64_t>(data.nextLoadOff));
+    }
+    if (format)
+      prefs.putUChar(KEY_UPLOAD_FORMAT, data.uploadFormat);
+    prefs.end();
+    DBG_PRINTF("[PersistentState] Flushed to NVS:%s%s%s%s%s\n", awakeTime ? " awake time" : "",
+               modemUsed ? " modem time" : "", failed ? " failed lines" : "", schedule ? " load schedule" : "",
+               format ? " upload format" : "");
+  }
+
+  if (awakeTime)
+    stored.totalAwakeTime = data.totalAwakeTime;
+  stored.lastModemUsedTime = data.lastModemUsedTime;
+  stored.failedLines       = data.failedLines;
+  stored.nextLoadOn        = data.nextLoadOn;
+  stored.nextLoadOff       = data.nextLoadOff;
+  stored.uploadFormat      = data.uploadFormat;
+  block_.crc               = checksum();
+}
@@ -0,0 +1,94 @@
+#include "PowerSavingGrant.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+constexpr size_t MAX_FIELDS = 10;
+
+// splits a "+CMD: a,"b",c" report into unquoted fields, returns the field count
+size_t splitReport(const char* report, const char* prefix, char (&copy)[96], char* (&fields)[MAX_FIELDS]) {
+  const size_t prefixLength = strlen(prefix);
+  if (strncmp(report, prefix, prefixLength) == 0)
+    report += prefixLength;
+  while (*report == ' ')
+    ++report;
+
+  strncpy(copy, report, sizeof(copy) - 1);
+  copy[sizeof(copy) - 1] = '\0';
+  copy[strcspn(copy, "\r\n")] = '\0';
+
+  size_t count = 0;
+  for (char* field = copy; field != nullptr && count < MAX_FIELDS; ++count) {
+    fields[count] = field;
+    field         = strchr(field, ',');
+    if (field != nullptr)
+      *field++ = '\0';
+    char*& value = fields[count];
+    if (*value == '"') {
+      ++value;
+      char* end = strchr(value, '"');
+      if (end != nullptr)
+        *end = '\0';
+    }
+  }
+  return count;
+}
+
+uint32_t timerSeconds(const uint8_t timer, const uint32_t (&units)[8]) {
+  return (timer & 0x1F) * units[timer >> 5];
+}
+}  // namespace
+
+bool PowerSavingGrant::isPsmGranted() const {
+  return activeTime != NOT_GRANTED && periodicTau != NOT_GRANTED;
+}
+
+uint32_t PowerSavingGrant::activeTimeSeconds() const {
+  // GPRS timer 2 units: 2 s, 1 min, 6 min, the rest deactivated
+  constexpr uint32_t UNITS[8] = {2, 60, 360, 60, 60, 60, 60, 0};
+  return isPsmGranted() ? timerSeconds(activeTime, UNITS) : 0;
+}
+
+uint32_t PowerSavingGrant::periodicTauSeconds() const {
+  // GPRS timer 3 units: 10 min, 1 h, 10 h, 2 s, 30 s, 1 min, 320 h, deactivated
+  constexpr uint32_t UNITS[8] = {600, 3600, 36000, 2, 30, 60, 1152000, 0};
+  return isPsmGranted() ? timerSeconds(periodicTau, UNITS) : 0;
+}
+
+bool PowerSavingGrant::parseRegistration(const char* report) {
+  char  copy[96];
+  char* fields[MAX_FIELDS];
+  const size_t count = splitReport(report, "+CEREG:", copy, fields);
+  if (count < 2 || *fields[1] == '\0')
+    return false;
+
+  registration = static_cast<int8_t>(strtol(fields[1], nullptr, 10));
+  activeTime   = count > 7 ? parseTimer(fields[7]) : NOT_GRANTED;
+  periodicTau  = count > 8 ? parseTimer(fields[8]) : NOT_GRANTED;
+  return true;
+}
+
+bool PowerSavingGrant::parseEdrx(const char* report) {
+  char  copy[96];
+  char* fields[MAX_FIELDS];
+  const size_t count = splitReport(report, "+CEDRXRDP:", copy, fields);
+  if (count < 1 || *fields[0] == '\0')
+    return false;
+
+  // the network provided value is the third field, without it the cell does not use eDRX
+  edrx = strtol(fields[0], nullptr, 10) != 0 && count > 2 && *fields[2] != '\0';
+  return true;
+}
+
+uint8_t PowerSavingGrant::parseTimer(const char* bits) {
+  if (strlen(bits) != 8)
+    return NOT_GRANTED;
+  uint8_t timer = 0;
+  for (size_t i = 0; i < 8; ++i) {
+    if (bits[i] != '0' && bits[i] != '1')
+      return NOT_GRANTED;
+    timer = static_cast<uint8_t>(timer << 1 | (bits[i] - '0'));
+  }
+  return (timer & 0xE0) == NOT_GRANTED ? NOT_GRANTED : timer;
+}
@@ -0,0 +1,59 @@
+#include "RadioMetrics.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+constexpr size_t MAX_FIELDS = 14;
+
+RadioAccess parseAccess(const char* mode) {
+  if (strcmp(mode, "LTE") == 0)
+    return RadioAccess::Lte;
+  if (strcmp(mode, "GSM") == 0)
+    return RadioAccess::Gsm;
+  if (strcmp(mode, "WCDMA") == 0)
+    return RadioAccess::Wcdma;
+  return RadioAccess::Unknown;
+}
+
+int16_t parseLevel(const char* field) {
+  char*      end   = nullptr;
+  const long value = strtol(field, &end, 10);
+  return end != field && value > INT16_MIN && value <= INT16_MAX ? static_cast<int16_t>(value)
+                                                                  : RadioMetrics::NOT_REPORTED;
+}
+}  // namespace
+
+bool RadioMetrics::parseSystemInformation(const char* info) {
+  constexpr char PREFIX[] = "+CPSI: ";
+  if (strncmp(info, PREFIX, sizeof(PREFIX) - 1) == 0)
+    info += sizeof(PREFIX) - 1;
+
+  char copy[128];
+  strncpy(copy, info, sizeof(copy) - 1);
+  copy[sizeof(copy) - 1] = '\0';
+
+  char*  fields[MAX_FIELDS];
+  size_t count = 0;
+  for (char* field = copy; field != nullptr && count < MAX_FIELDS; ++count) {
+    fields[count] = field;
+    field         = strchr(field, ',');
+    if (field != nullptr)
+      *field++ = '\0';
+  }
+  if (count < 5 || strcmp(fields[1], "Online") != 0)
+    return false;
+
+  char* separator = nullptr;  // between MCC and MNC
+  access          = parseAccess(fields[0]);
+  mcc             = static_cast<uint16_t>(strtoul(fields[2], &separator, 10));
+  mnc             = *separator == '-' ? static_cast<uint16_t>(strtoul(separator + 1, nullptr, 10)) : 0;
+  areaCode        = static_cast<uint16_t>(strtoul(fields[3], nullptr, 16));
+  cellId          = strtoul(fields[4], nullptr, 10);
+  if (access == RadioAccess::Lte && count >= MAX_FIELDS) {
+    rsrq = parseLevel(fields[10]);
+    rsrp = parseLevel(fields[11]);
+    sinr = parseLevel(fields[13]);
+  }
+  return true;
+}
@@ -3,18 +3,31 @@
 //
 #include "SleepManager.h"
 
-#include <Preferences.h>
-
+#include "EnergyModel.h"
 #include "Globals.h"
 #include "ICommunicationService.h"
-
-constexpr auto KEY_TOTAL_AWAKE_TIME = "awake_time";
-Preferences    sleepPrefs;
+#include "PersistentState.h"
+#include "WakeProfiler.h"
 
 SleepManager::SleepManager() : wakeStartMillis(millis()) {
 }
 
 void SleepManager::activateDeepSleep() {
+  prepareForSleep();
+#if MPPT_WAKE_PROFILE
+  WakeProfiler::finishWake();
+  const EnergyModel model(DEFAULT_ENERGY_CURRENTS);
+  EnergyLedger::addWake(model.wakeCharge(WakeProfiler::lastWakeUs(), DEEP_SLEEP_DURATION), time(nullptr));
+#endif
+  // put ESP to deep sleep
+  DBG_PRINTLN("[SleepManager] Going to deep sleep...");
+  DBG_PRINTLN("---------------------------");
+  esp_sleep_enable_timer_wakeup(DEEP_SLEEP_DURATION * uS_TO_S_FACTOR);
+  esp_deep_sleep_start();
+}
+
+void SleepManager::prepareForSleep() {
+  PROFILE_PHASE(WakePhase::SleepEntry);
   DBG_PRINT("[SleepManager] Power off modem ...");
   communicationService->powerOffModem();
   DBG_PRINTLN("done");
@@ -25,11 +38,7 @@ void SleepManager::activateDeepSleep() {
   const uint32_t sessionAwake = (millis() - wakeStartMillis) / 1000;
 
   totalAwakeTime += sessionAwake;
-
-  // save updated total awake time to NVS
-  sleepPrefs.begin(PREF_NAME, false);  // read/write
-  sleepPrefs.putULong64(KEY_TOTAL_AWAKE_TIME, totalAwakeTime);
-  sleepPrefs.end();
+  PersistentState::data().totalAwakeTime = totalAwakeTime;
 
   DBG_PRINTF(
       "[SleepManager] Saving total awake time: %llu seconds (this "
@@ -41,22 +50,17 @@ void SleepManager::activateDeepSleep() {
   tm           t;
   localtime_r(&now, &t);
   storedEpoch = now;
-  // put ESP to deep sleep
-  DBG_PRINTLN("[SleepManager] Going to deep sleep...");
-  DBG_PRINTLN("---------------------------");
-  esp_sleep_enable_timer_wakeup(DEEP_SLEEP_DURATION * uS_TO_S_FACTOR);
-  esp_deep_sleep_start();
+  // the only NVS write of the wake, and only for values that changed
+  PersistentState::flush();
 }
 
 /**
  * Handles basic events after wake-up
  */
 void SleepManager::afterWakeUpSetup() {
+  PROFILE_PHASE(WakePhase::WakeSetup);
   wakeStartMillis = millis();
-  // Load previous total awake time from NVS
-  sleepPrefs.begin(PREF_NAME, true);  // read-only
-  totalAwakeTime = sleepPrefs.getULong64(KEY_TOTAL_AWAKE_TIME, 0);
-  sleepPrefs.end();
+  totalAwakeTime  = PersistentState::data().totalAwakeTime;
 
   if (!wakenFromDeepSleep)
     return;
@@ -1,5 +1,6 @@
 #include "SolarMPPTMonitor.h"
 
+#include <esp_attr.h>
 #include <time.h>
 
 #include <iterator>
@@ -7,9 +8,10 @@
 #include "Globals.h"
 #include "LoggingService.h"
 #include "TimeService.h"
+#include "WakeProfiler.h"
 
-constexpr int MAX_RETRIES    = 3;   // how many times to retry
-constexpr int RETRY_DELAY_MS = 50;  // delay between retries (optional)
+constexpr int MAX_RETRIES    = 3;   // attempts per request
+constexpr int RETRY_DELAY_MS = 50;  // delay before a fast retry
 
 void preTransmission() {
   digitalWrite(RS485_DERE, HIGH);
@@ -19,6 +21,11 @@ void postTransmission() {
   digitalWrite(RS485_DERE, LOW);
 }
 
+RegisterSnapshot SolarMPPTMonitor::snapshot_;
+ModbusLinkHealth   SolarMPPTMonitor::linkHealth_;
+ModbusRttEstimator SolarMPPTMonitor::rttEstimator_;
+RTC_DATA_ATTR uint64_t SolarMPPTMonitor::splitWindows_ = 0;
+
 SolarMPPTMonitor::SolarMPPTMonitor() = default;
 
 void SolarMPPTMonitor::initOrResetRS485(bool existingCollection) {
@@ -34,63 +41,89 @@ void SolarMPPTMonitor::initOrResetRS485(bool existingCollection) {
   RS485Serial.begin(RS485_BAUD, SERIAL_8N1, RS485_RXD, RS485_TXD);
   delay(100);  // nech sa UART inicializuje
 
-  node.begin(1, RS485Serial);
+  node.begin(1, RS485Serial, RS485_BAUD);
+  node.setRttEstimator(&rttEstimator_);
   node.preTransmission(preTransmission);
   node.postTransmission(postTransmission);
 }
 
-bool SolarMPPTMonitor::readRegister(const RegisterInfo& reg, float& outValue) {
-  uint8_t count = (reg.type == REG_U32 || reg.type == REG_S32) ? 2 : 1;
-
-  uint8_t result = node.readInputRegisters(reg.address, count);
-  if (result != node.ku8MBSuccess) {
-    initOrResetRS485(true);
-    return false;
-  }
-
-  switch (reg.type) {
-    case REG_U16: {
-      uint16_t raw = node.getResponseBuffer(0);
-      outValue     = raw * reg.scale;
-      break;
-    }
-    case REG_S16: {
-      int16_t raw = (int16_t) node.getResponseBuffer(0);
-      outValue    = raw * reg.scale;
-      break;
+template <typename Request>
+uint8_t SolarMPPTMonitor::runTransaction(uint16_t address, uint16_t count, Request request) {
+  // every transaction of the wake, wherever it is issued from (load control, RTC sync, the poll), is bus time
+  PROFILE_PHASE(WakePhase::ModbusPoll);
+  uint8_t result = ModbusRtuMaster::ku8MBResponseTimedOut;
+  for (int attempt = 1; attempt <= MAX_RETRIES; ++attempt) {
+    if (!linkHealth_.allowRequest()) {
+      DBG_PRINTF("[SolarMPPTMonitor] Link breaker open, skipping request 0x%04X\n", address);
+      return result;
     }
-    case REG_U32: {
-      uint16_t low      = node.getResponseBuffer(0);
-      uint16_t high     = node.getResponseBuffer(1);
-      uint32_t combined = ((uint32_t) high << 16) | low;
-      outValue          = combined * reg.scale;
-      break;
+
+    linkHealth_.recordAttempt();
+    result = request();
+    if (result == ModbusRtuMaster::ku8MBSuccess) {
+      linkHealth_.recordSuccess(address, count);
+      return result;
     }
-    case REG_S32: {
-      uint16_t low      = node.getResponseBuffer(0);
-      uint16_t high     = node.getResponseBuffer(1);
-      uint32_t raw      = ((uint32_t) high << 16) | low;
-      int32_t  combined = *(int32_t*) &raw;
-      outValue          = combined * reg.scale;
-      break;
+
+    const LinkAction action = linkHealth_.recordFailure(address, count, result);
+    DBG_PRINTF("[SolarMPPTMonitor] Request 0x%04X attempt %d failed, code: 0x%02X\n", address, attempt, result);
+    switch (action) {
+      case LinkAction::Retry:
+        delay(RETRY_DELAY_MS);
+        break;
+      case LinkAction::ExtendTimeout:
+        node.extendResponseTimeout();
+        break;
+      case LinkAction::ResetUart:
+        linkHealth_.recordReset();
+        initOrResetRS485(true);
+        break;
+      case LinkAction::GiveUp:
+        if (linkHealth_.counters().breakerOpen)
+          DBG_PRINTLN("[SolarMPPTMonitor] MPPT not responding, link breaker opened for this wake");
+        return result;
     }
   }
+  return result;
+}
+
+bool SolarMPPTMonitor::readRegister(const RegisterInfo& reg, uint32_t& outValue) {
+  uint8_t result = runTransaction(reg.address, registerWords(reg),
+                                  [&] { return node.readInputRegisters(reg.address, registerWords(reg)); });
+  if (result != node.ku8MBSuccess)
+    return false;
+
+  outValue = decodeRegister(reg, 0);
   return true;
 }
 
+uint8_t SolarMPPTMonitor::readRegisterBlock(const ReadWindow& window) {
+  uint8_t result =
+      runTransaction(window.start, window.count, [&] { return node.readInputRegisters(window.start, window.count); });
+  if (result != node.ku8MBSuccess)
+    DBG_PRINTF("[SolarMPPTMonitor] Block read 0x%04X+%u failed, code: %u\n", window.start, window.count, result);
+  return result;
+}
+
+uint32_t SolarMPPTMonitor::decodeRegister(const RegisterInfo& reg, uint8_t offset) {
+  if (registerWords(reg) == 1)
+    return node.getResponseBuffer(offset);
+  // 32-bit values are sent low word first
+  return ((uint32_t) node.getResponseBuffer(offset + 1) << 16) | node.getResponseBuffer(offset);
+}
+
 bool SolarMPPTMonitor::readHoldingRegister(uint16_t address, uint16_t& outValue) {
-  uint8_t result = node.readHoldingRegisters(address, 1);  // funkcia 0x03
+  uint8_t result = runTransaction(address, 1, [&] { return node.readHoldingRegisters(address, 1); });  // funkcia 0x03
   if (result == node.ku8MBSuccess) {
     outValue = node.getResponseBuffer(0);
     return true;
   }
-  initOrResetRS485(true);
   return false;
 }
 
 bool SolarMPPTMonitor::writeHoldingRegister(uint16_t address, uint16_t value) {
   // Use function 0x06 (write single register)
-  uint8_t result = node.writeSingleRegister(address, value);
+  uint8_t result = runTransaction(address, 1, [&] { return node.writeSingleRegister(address, value); });
   if (result == node.ku8MBSuccess) {
     DBG_PRINT("[SolarMPPTMonitor] Register 0x");
     DBG_PRINT2(address, HEX);
@@ -102,30 +135,40 @@ bool SolarMPPTMonitor::writeHoldingRegister(uint16_t address, uint16_t value) {
   DBG_PRINT2(address, HEX);
   DBG_PRINT(": ");
   DBG_PRINTLN(result);
-  initOrResetRS485(true);
   return false;
 }
 
 bool SolarMPPTMonitor::readLoadState(int& loadState) {
+  if (snapshot_.loadStateValid) {
+    loadState = snapshot_.loadState;
+    return true;
+  }
+
   // coil 0x0002 = Remote control of load
-  uint8_t result = node.readCoils(0x0002, 1);
+  uint8_t result = runTransaction(0x0002, 1, [] { return node.readCoils(0x0002, 1); });
   loadState      = -1;
   if (result == node.ku8MBSuccess) {
-    loadState = node.getResponseBuffer(0);
+    loadState                = node.getResponseBuffer(0);
+    snapshot_.loadState      = loadState;
+    snapshot_.loadStateValid = true;
     DBG_PRINT("[SolarMPPTMonitor] Current LOAD state in MPPT: ");
     DBG_PRINTLN(loadState ? "ON ✅" : "OFF ❌");
     return true;
   } else {
     DBG_PRINT("[SolarMPPTMonitor] Error during read LOAD, code: ");
     DBG_PRINTLN(result);
-    initOrResetRS485(true);
     return false;
   }
 }
 
 bool SolarMPPTMonitor::setLoad(bool enable) {
-  const uint8_t result = node.writeSingleCoil(0x0002, enable);  // Coil 2 = Load control
+  // Coil 2 = Load control
+  const uint8_t result = runTransaction(0x0002, 1, [&] { return node.writeSingleCoil(0x0002, enable); });
+  // re-read the coil on next use, whatever the outcome of the write
+  snapshot_.loadStateValid = false;
   if (result == node.ku8MBSuccess) {
+    // the load output, the battery discharge and the discharging flags change with it
+    snapshot_.registers.invalidate(LOAD_REGISTER_MASK);
     DBG_PRINT("[SolarMPPTMonitor] LOAD set to MPPT: ");
     DBG_PRINTLN(enable ? "ON" : "OFF");
     return true;
@@ -134,37 +177,104 @@ bool SolarMPPTMonitor::setLoad(bool enable) {
     DBG_PRINT(enable ? "turning on" : "turning off");
     DBG_PRINT(" LOAD, code: ");
     DBG_PRINTLN(result);
-    initOrResetRS485(true);
     return false;
   }
 }
 
-LogEntry SolarMPPTMonitor::readLogsFromMPPT() {
-  DBG_PRINTLN("[SolarMPPTMonitor] Reading from MPPT");
-  int loadState;
-  readLoadState(loadState);
-  LogEntry logEntry(timeService.getTimeUTC(), loadState);
+bool SolarMPPTMonitor::readRegisterIntoSnapshot(size_t index) {
+  const RegisterInfo& reg = mpptReadRegisters[index];
+  uint32_t            value;
+  if (readRegister(reg, value)) {
+    snapshot_.registers.set(index, value);
+    return true;
+  }
+  DBG_PRINT("[SolarMPPTMonitor] Unable to read after retries: ");
+  DBG_PRINTLN(reg.name);
+  return false;
+}
 
-  for (auto& r : mpptReadRegisters) {
-    float value;
-    bool  success = false;
+/**
+ * Fills the snapshot from the MPPT. Only windows that still contain a value missing from the snapshot are read, so
+ * calling this repeatedly within one wake costs no further transactions.
+ *
+ * A window bridges unused addresses. A controller that answers such a window with "illegal data address" gets the
+ * window read in its gap-free parts instead; the window is remembered in RTC memory, so later wakes go straight to
+ * the parts.
+ */
+bool SolarMPPTMonitor::pollRegisters() {
+  bool allOk = true;
 
-    for (int attempt = 1; attempt <= MAX_RETRIES; ++attempt) {
-      if (readRegister(r, value)) {
-        success = true;
-        break;
+  // windows are laid out in address order, so walking plan.order visits them one after another
+  size_t next = 0;
+  for (size_t w = 0; w < mpptReadPlan.windowCount; ++w) {
+    const size_t first = next;
+    bool         stale = false;
+    for (; next < mpptReadRegistersCount && mpptReadPlan.slots[mpptReadPlan.order[next]].window == w; ++next) {
+      stale |= !snapshot_.registers.isValid(mpptReadPlan.order[next]);
+    }
+    if (!stale)
+      continue;
+
+    const uint64_t windowBit = 1ULL << w;
+    if ((splitWindows_ & windowBit) == 0) {
+      const uint8_t result = readRegisterBlock(mpptReadPlan.windows[w]);
+      if (result == node.ku8MBSuccess) {
+        for (size_t i = first; i < next; ++i) {
+          const uint8_t index = mpptReadPlan.order[i];
+          snapshot_.registers.set(index, decodeRegister(mpptReadRegisters[index], mpptReadPlan.slots[index].offset));
+        }
+        continue;
+      }
+      if (result == node.ku8MBIllegalDataAddress) {
+        splitWindows_ |= windowBit;
+        DBG_PRINTF("[SolarMPPTMonitor] Window 0x%04X+%u rejected, reading it in parts from now on\n",
+                   mpptReadPlan.windows[w].start, mpptReadPlan.windows[w].count);
       }
-      DBG_PRINTF("[SolarMPPTMonitor] Read attempt %d failed for %s (0x%04X)\n", attempt, r.name, r.address);
-      delay(RETRY_DELAY_MS);
     }
+    allOk &= pollWindowParts(first, next);
+  }
+  return allOk;
+}
 
-    if (success) {
-      logEntry.addValue(r.address, value);
-    } else {
-      DBG_PRINT("[SolarMPPTMonitor] Unable to read after retries: ");
-      DBG_PRINTLN(r.name);
+/**
+ * Reads the registers plan.order[first, last) of one window in runs without unused addresses between them. A run that
+ * fails falls back to single reads of its missing registers.
+ */
+bool SolarMPPTMonitor::pollWindowParts(size_t first, size_t last) {
+  bool allOk = true;
+  for (size_t begin = first; begin < last;) {
+    const RegisterInfo& head  = mpptReadRegisters[mpptReadPlan.order[begin]];
+    ReadWindow          part  = {head.address, registerWords(head)};
+    bool                stale = !snapshot_.registers.isValid(mpptReadPlan.order[begin]);
+    size_t              end   = begin + 1;
+    for (; end < last && mpptReadRegisters[mpptReadPlan.order[end]].address == part.start + part.count; ++end) {
+      part.count += registerWords(mpptReadRegisters[mpptReadPlan.order[end]]);
+      stale |= !snapshot_.registers.isValid(mpptReadPlan.order[end]);
     }
+
+    const bool success = stale && end - begin > 1 && readRegisterBlock(part) == node.ku8MBSuccess;
+    for (size_t i = begin; i < end; ++i) {
+      const uint8_t       index = mpptReadPlan.order[i];
+      const RegisterInfo& reg   = mpptReadRegisters[index];
+      if (success)
+        snapshot_.registers.set(index, decodeRegister(reg, reg.address - part.start));
+      else if (!snapshot_.registers.isValid(index))
+        allOk &= readRegisterIntoSnapshot(index);
+    }
+    begin = end;
   }
+  return allOk;
+}
+
+LogEntry SolarMPPTMonitor::readLogsFromMPPT() {
+  DBG_PRINTLN("[SolarMPPTMonitor] Reading from MPPT");
+  int loadState;
+  readLoadState(loadState);
+  LogEntry logEntry(timeService.getTimeUTC(), loadState);
+
+  pollRegisters();
+  logEntry.setValues(snapshot_.registers);
+  logEntry.setLinkCounters(linkHealth_.counters());
 
   return logEntry;
 }
@@ -203,7 +313,8 @@ bool SolarMPPTMonitor::setDatetimeInMPPT() {
   node.setTransmitBuffer(2, regMonthYear);
 
   // Write 3 registers starting from base address
-  uint8_t result = node.writeMultipleRegisters(HR_RTC_SecondMinute, 3);
+  uint8_t result =
+      runTransaction(HR_RTC_SecondMinute, 3, [] { return node.writeMultipleRegisters(HR_RTC_SecondMinute, 3); });
 
   if constexpr (DEBUG) {
     DateTimeFields rtc{};
@@ -240,28 +351,21 @@ bool SolarMPPTMonitor::readDatetimeInMPPT(DateTimeFields& dt) {
 }
 
 bool SolarMPPTMonitor::readBatteryStatus(float& socPercent, float& tempC) {
-  bool allOk = true;
+  pollRegisters();
 
-  // Battery SOC (0x311A), scale 1.0f
-  {
-    RegisterInfo regSoc = {0x311A, "Battery SOC (%)", 1.0f, REG_U16};
-    float        rawSoc = 0.0f;
-    if (readRegister(regSoc, rawSoc)) {
-      socPercent = rawSoc;  // already scaled
-    } else {
-      allOk = false;
-    }
+  bool allOk = true;
+  if (snapshot_.registers.isValid(REG_IDX_BATTERY_SOC)) {
+    socPercent =
+        scaledRegisterValue(mpptReadRegisters[REG_IDX_BATTERY_SOC], snapshot_.registers.raw[REG_IDX_BATTERY_SOC]);
+  } else {
+    allOk = false;
   }
 
-  // Battery Temperature (0x3110), scale 0.01f
-  {
-    RegisterInfo regTemp = {0x3110, "Remote Battery Temp (°C)", 0.01f, REG_U16};
-    float        rawTemp = 0.0f;
-    if (readRegister(regTemp, rawTemp)) {
-      tempC = rawTemp;  // already scaled
-    } else {
-      allOk = false;
-    }
+  if (snapshot_.registers.isValid(REG_IDX_BATTERY_TEMP)) {
+    tempC =
+        scaledRegisterValue(mpptReadRegisters[REG_IDX_BATTERY_TEMP], snapshot_.registers.raw[REG_IDX_BATTERY_TEMP]);
+  } else {
+    allOk = false;
   }
 
   return allOk;  // true only if both succeeded
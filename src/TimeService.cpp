@@ -2,10 +2,10 @@
 
 #include <time.h>
 
+#include "ModemSession.h"
+#include "PersistentState.h"
 #include "SolarMPPTMonitor.h"
 
-constexpr auto KEY_LAST_MODEM_USED_TIME = "l_usd_m";
-
 time_t TimeService::getTimeUTC() {
   if (!isTimeInitializedFromModem)
     return 0;
@@ -104,12 +104,17 @@ time_t TimeService::parseISO8601(const char* isoStr) {
   return 0;
 }
 
+bool TimeService::isTimeValid() {
+  return getTimeUTC() >= 1577836800;  // 2020-01-01
+}
+
 bool TimeService::isTimeToUseModem() {
-  Preferences prefs;
-  prefs.begin(PREF_NAME, true);
-  ulong  lastModemUsedTime = prefs.getULong(KEY_LAST_MODEM_USED_TIME, -1);
-  size_t failedLines       = prefs.getUInt(FAILED_LINES_COUNT, 0);
-  prefs.end();
+  const ulong  lastModemUsedTime = PersistentState::data().lastModemUsedTime;
+  const size_t failedLines       = PersistentState::data().failedLines;
+  if (ModemSession::isBackingOff()) {
+    DBG_PRINTLN(F("[TimeService] Last modem session failed, backing off."));
+    return false;
+  }
   if (failedLines > 0) {
     DBG_PRINTF("[TimeService] Failed Lines (count: %d) will be synced in this loop.\n", failedLines);
     // Treat as first run
@@ -119,7 +124,7 @@ bool TimeService::isTimeToUseModem() {
   tm     utc;
   gmtime_r(&nowEpoch, &utc);
 
-  if (nowEpoch < 1577836800) {
+  if (!isTimeValid()) {
     DBG_PRINTF("[TimeService] 🚀 Time not valid yet (epoch=%ld)\n", nowEpoch);
     // Treat as first run
     return true;
@@ -138,11 +143,7 @@ bool TimeService::isTimeToUseModem() {
   return false;
 }
 ulong TimeService::getLastModemPreference() {
-  Preferences prefs;
-  prefs.begin(PREF_NAME, true);
-  ulong lastModemUsedTime = prefs.getULong(KEY_LAST_MODEM_USED_TIME, -1);
-  prefs.end();
-  return lastModemUsedTime;
+  return PersistentState::data().lastModemUsedTime;
 }
 
 void TimeService::updateLastModemPreference() {
@@ -150,10 +151,7 @@ void TimeService::updateLastModemPreference() {
   tm     utc;
   gmtime_r(&nowEpoch, &utc);
 
-  Preferences prefs;
-  prefs.begin(PREF_NAME, false);
-  prefs.putULong(KEY_LAST_MODEM_USED_TIME, nowEpoch);
-  prefs.end();
+  PersistentState::data().lastModemUsedTime = nowEpoch;
 
   DBG_PRINTLN(F("[TimeService] ---- updateLastModemPreference ----"));
   DBG_PRINTF("[TimeService] Stored new value KEY_LAST_MODEM_USED_TIME: %lu\n", nowEpoch);
@@ -0,0 +1,131 @@
+#include "UploadEncoder.h"
+
+#include "LogChunkEncoder.h"
+
+static_assert(LogEntry::MAX_PRINT_LENGTH + 2 < MPPT_UPLOAD_BATCH_BYTES, "a single entry must fit into a batch");
+static_assert(WakeReport::MAX_PRINT_LENGTH + 2 < MPPT_UPLOAD_BATCH_BYTES, "the report must fit into a batch");
+
+BufferedUploadEncoder::~BufferedUploadEncoder() {
+  free(buffer_);
+}
+
+bool BufferedUploadEncoder::begin() {
+  if (buffer_ == nullptr)
+    buffer_ = static_cast<uint8_t*>(ps_malloc(MPPT_UPLOAD_BATCH_BYTES));
+  if (buffer_ == nullptr)
+    buffer_ = static_cast<uint8_t*>(malloc(MPPT_UPLOAD_BATCH_BYTES));
+  if (buffer_ == nullptr)
+    return false;
+  body_  = BufferPrint(buffer_, MPPT_UPLOAD_BATCH_BYTES);
+  count_ = 0;
+  return true;
+}
+
+bool BufferedUploadEncoder::add(const LogEntry& entry) {
+  if (count_ >= MPPT_UPLOAD_BATCH_RECORDS)
+    return false;
+  const size_t start = body_.length();
+  print(entry);
+  return commit(start);
+}
+
+bool BufferedUploadEncoder::add(const WakeReport& report) {
+  if (count_ >= MPPT_UPLOAD_BATCH_RECORDS)
+    return false;
+  const size_t start = body_.length();
+  print(report);
+  return commit(start);
+}
+
+bool BufferedUploadEncoder::commit(const size_t start) {
+  // items are streamed straight into the body, an item that does not fit (leaving a byte for finish()) is rolled back
+  if (body_.overflowed() || body_.remaining() == 0) {
+    body_.truncate(start);
+    return false;
+  }
+  ++count_;
+  return true;
+}
+
+void BufferedUploadEncoder::clear() {
+  body_.truncate(0);
+  count_ = 0;
+}
+
+void JsonUploadEncoder::print(const LogEntry& entry) {
+  body_.write(count_ == 0 ? '[' : ',');
+  entry.printJson(body_);
+}
+
+void JsonUploadEncoder::print(const WakeReport& report) {
+  body_.write(count_ == 0 ? '[' : ',');
+  report.printJson(body_);
+}
+
+const uint8_t* JsonUploadEncoder::finish(size_t& length) {
+  body_.write(']');
+  length = body_.length();
+  return body_.data();
+}
+
+const uint8_t* LineProtocolUploadEncoder::finish(size_t& length) {
+  length = body_.length();
+  return body_.data();
+}
+
+void MsgPackUploadEncoder::printHeader() {
+  if (count_ == 0) {
+    const uint8_t header[] = {ARRAY32, 0, 0, 0, 0};
+    body_.write(header, sizeof(header));
+  }
+}
+
+void MsgPackUploadEncoder::print(const LogEntry& entry) {
+  printHeader();
+  JsonDocument doc;
+  entry.toDocument(doc, true);
+  serializeMsgPack(doc, body_);
+}
+
+void MsgPackUploadEncoder::print(const WakeReport& report) {
+  printHeader();
+  JsonDocument doc;
+  report.toDocument(doc);
+  serializeMsgPack(doc, body_);
+}
+
+const uint8_t* MsgPackUploadEncoder::finish(size_t& length) {
+  uint8_t* header = body_.data();
+  header[1]       = count_ >> 24;
+  header[2]       = count_ >> 16;
+  header[3]       = count_ >> 8;
+  header[4]       = count_;
+  length          = body_.length();
+  return header;
+}
+
+ChunkUploadEncoder::~ChunkUploadEncoder() {
+  free(entries_);
+  free(chunk_);
+}
+
+bool ChunkUploadEncoder::begin() {
+  if (entries_ == nullptr)
+    entries_ = static_cast<LogEntry*>(ps_malloc(MPPT_UPLOAD_CHUNK_RECORDS * sizeof(LogEntry)));
+  if (chunk_ == nullptr)
+    chunk_ = static_cast<uint8_t*>(ps_malloc(LogChunkEncoder::maxEncodedSize(MPPT_UPLOAD_CHUNK_RECORDS)));
+  return entries_ != nullptr && chunk_ != nullptr;
+}
+
+bool ChunkUploadEncoder::add(const LogEntry& entry) {
+  if (count_ >= MPPT_UPLOAD_CHUNK_RECORDS)
+    return false;
+  entries_[count_++] = entry;
+  return true;
+}
+
+const uint8_t* ChunkUploadEncoder::finish(size_t& length) {
+  const size_t capacity = LogChunkEncoder::maxEncodedSize(MPPT_UPLOAD_CHUNK_RECORDS);
+  length                = LogChunkEncoder::encode(entries_, count_, chunk_, capacity);
+  return chunk_;
+}
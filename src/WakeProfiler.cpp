@@ -0,0 +1,97 @@
+#include "WakeProfiler.h"
+
+#if MPPT_WAKE_PROFILE
+#include <esp_attr.h>
+
+#include <algorithm>
+
+namespace {
+constexpr uint32_t MAGIC = 0x57505231;  // "WPR1"
+
+struct PhaseWindow {
+  uint32_t minUs;
+  uint32_t maxUs;
+  uint64_t totalUs;
+  uint16_t runs;  // wakes of the window the phase ran in
+};
+
+struct Window {
+  uint16_t    wakes;
+  PhaseWindow phases[WAKE_PHASE_COUNT];
+};
+
+struct Profile {
+  uint32_t magic;
+  uint32_t lastUs[WAKE_PHASE_COUNT];  // previous wake, 0 when the phase did not run
+  Window   current;
+  Window   completed;  // last full window, no wakes until the first one is complete
+};
+
+RTC_DATA_ATTR Profile rtcProfile;
+
+uint32_t wakeUs[WAKE_PHASE_COUNT];
+uint16_t wakeRan = 0;  // bit per phase
+
+uint16_t toMs(const uint64_t us) {
+  return static_cast<uint16_t>(std::min<uint64_t>((us + 999) / 1000, UINT16_MAX));
+}
+}  // namespace
+
+void WakeProfiler::begin() {
+  if (rtcProfile.magic == MAGIC && rtcProfile.current.wakes < MPPT_WAKE_PROFILE_WINDOW)
+    return;
+  rtcProfile       = {};
+  rtcProfile.magic = MAGIC;
+}
+
+void WakeProfiler::record(const WakePhase phase, const uint32_t durationUs) {
+  const size_t index = static_cast<size_t>(phase);
+  wakeUs[index] += durationUs;
+  wakeRan |= 1u << index;
+}
+
+void WakeProfiler::finishWake() {
+  record(WakePhase::Awake, static_cast<uint32_t>(esp_timer_get_time()));
+
+  Window& window = rtcProfile.current;
+  for (size_t i = 0; i < WAKE_PHASE_COUNT; ++i) {
+    const bool ran       = wakeRan >> i & 1;
+    rtcProfile.lastUs[i] = ran ? wakeUs[i] : 0;
+    if (!ran)
+      continue;
+    PhaseWindow& phase = window.phases[i];
+    phase.minUs        = phase.runs == 0 ? wakeUs[i] : std::min(phase.minUs, wakeUs[i]);
+    phase.maxUs        = std::max(phase.maxUs, wakeUs[i]);
+    phase.totalUs += wakeUs[i];
+    ++phase.runs;
+    DBG_PRINTF("[WakeProfiler] %-12s %8u us\n", WAKE_PHASE_NAMES[i], wakeUs[i]);
+  }
+  if (++window.wakes >= MPPT_WAKE_PROFILE_WINDOW) {
+    rtcProfile.completed = window;
+    window               = {};
+  }
+}
+
+const uint32_t (&WakeProfiler::lastWakeUs())[WAKE_PHASE_COUNT] {
+  return rtcProfile.lastUs;
+}
+
+WakeProfile WakeProfiler::profile() {
+  WakeProfile profile{};
+  for (size_t i = 0; i < WAKE_PHASE_COUNT; ++i)
+    profile.lastMs[i] = toMs(rtcProfile.lastUs[i]);
+
+  const Window& window = rtcProfile.completed.wakes > 0 ? rtcProfile.completed : rtcProfile.current;
+  profile.windowWakes  = window.wakes;
+  for (size_t i = 0; i < WAKE_PHASE_COUNT; ++i) {
+    const PhaseWindow& phase = window.phases[i];
+    if (phase.runs == 0)
+      continue;
+    profile.minMs[i]  = toMs(phase.minUs);
+    profile.meanMs[i] = toMs(phase.totalUs / phase.runs);
+    profile.maxMs[i]  = toMs(phase.maxUs);
+  }
+  return profile;
+}
+
+#endif
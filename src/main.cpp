@@ -5,13 +5,16 @@
 #include "Globals.h"
 #include "LoadController.h"
 #include "LoggingService.h"
+#include "ModemSession.h"
+#include "PersistentState.h"
 #include "SleepManager.h"
 #include "SolarMPPTMonitor.h"
 #include "TimeService.h"
+#include "WakeProfiler.h"
 
-SleepManager   sleepManager;
-HardwareSerial RS485Serial(2);  // use UART2
-ModbusMaster   node;            // single Modbus master
+SleepManager    sleepManager;
+HardwareSerial  RS485Serial(2);  // use UART2
+ModbusRtuMaster node;            // single Modbus master
 
 #ifdef LILYGO_SIM800L
 #include "CommunicationSIM800L.h"
@@ -25,12 +28,25 @@ ICommunicationService* communicationService = &simA7670EInstance;
 TimeService    timeService;
 LoadController loadController;
 
+// joins the modem bring-up, then fetches the config (load schedule, time) and checks for an OTA update
+void syncWithServer() {
+  if (!communicationService->waitForModem())
+    return;
+  communicationService->downloadConfig();
+  communicationService->performOtaUpdate();
+}
+
 void setup() {
   esp_task_wdt_init(300, true);  // 5 minutes
   esp_task_wdt_add(nullptr);
   setenv("TZ", "CET-1CEST,M3.5.0/2,M10.5.0/3", 1);
   tzset();
 
+#if MPPT_WAKE_PROFILE
+  WakeProfiler::begin();
+#endif
+  PersistentState::load();
+  ModemSession::begin();
   sleepManager.afterWakeUpSetup();
   Serial.begin(115200);
   delay(100);
@@ -40,9 +56,10 @@ void setup() {
   loadController.setup();
 
   if (TimeService::isTimeToUseModem() && !communicationService->isModemOn()) {
-    communicationService->setupModem();
-    communicationService->downloadConfig();
-    communicationService->performOtaUpdate();
+    // registers on the other core while loop() reads the MPPT and logs the sample
+    communicationService->startModem();
+    if (!TimeService::isTimeValid())
+      syncWithServer();  // the sample needs the time from the server
   }
   esp_task_wdt_reset();
 }
@@ -50,14 +67,20 @@ void setup() {
 void loop() {
   esp_task_wdt_reset();
   loadController.setLoadBasedOnConfig();
-  if (communicationService->isModemOn()) {
+  if (communicationService->isModemStarting() || communicationService->isModemOn()) {
     // update modem used ts before log is generated
     TimeService::updateLastModemPreference();
   }
-  LoggingService::logMPPTEntryToFile(SolarMPPTMonitor::readLogsFromMPPT());
+  const LogEntry entry = SolarMPPTMonitor::readLogsFromMPPT();
+#ifdef MPPT_SERIALIZER_BENCH
+  LoggingService::benchmarkSerializers(entry);
+#endif
+  LoggingService::logMPPTEntryToFile(entry);
 
+  if (communicationService->isModemStarting())
+    syncWithServer();
   if (communicationService->isModemOn()) {
-    communicationService->sendMPPTPayload();
+    communicationService->sendMPPTPayload(LoadController::uploadFormat());
   }
   loadController.setLoadBasedOnConfig();
   esp_task_wdt_reset();
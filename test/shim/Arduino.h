@@ -0,0 +1,285 @@
+#pragma once
+
+/**
+ * Host stand-in for the parts of the Arduino core the firmware uses, for the `native` environment. Time comes from the
+ * host's monotonic clock, GPIO is a no-op and Serial prints to stdout; HardwareSerial.h maps a UART to a tty.
+ */
+
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+
+#include "esp_sleep.h"
+
+using byte = uint8_t;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define DEC 10
+#define HEX 16
+#define F(string_literal) (string_literal)
+#define IRAM_ATTR
+
+namespace native {
+inline const std::chrono::steady_clock::time_point bootTime = std::chrono::steady_clock::now();
+}  // namespace native
+
+inline unsigned long micros() {
+  return static_cast<unsigned long>(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - native::bootTime)
+          .count());
+}
+inline unsigned long millis() {
+  return micros() / 1000;
+}
+inline void delay(const unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+inline void delayMicroseconds(const unsigned int us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+inline void yield() {}
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int  digitalRead(uint8_t) {
+  return LOW;
+}
+
+inline void* ps_malloc(const size_t size) {
+  return malloc(size);
+}
+
+class String {
+ public:
+  String(const char* s = "") : s_(s != nullptr ? s : "") {}
+  String(const char* s, const size_t length) : s_(s, length) {}
+  String(const std::string& s) : s_(s) {}
+  explicit String(const char c) : s_(1, c) {}
+  explicit String(const int value) : s_(std::to_string(value)) {}
+  explicit String(const unsigned value) : s_(std::to_string(value)) {}
+  explicit String(const long value) : s_(std::to_string(value)) {}
+  explicit String(const unsigned long value) : s_(std::to_string(value)) {}
+  explicit String(const double value, const unsigned decimals = 2) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+    s_ = buffer;
+  }
+
+  String& operator=(const char* s) {
+    s_ = s != nullptr ? s : "";
+    return *this;
+  }
+
+  [[nodiscard]] const char* c_str() const { return s_.c_str(); }
+  [[nodiscard]] unsigned    length() const { return static_cast<unsigned>(s_.size()); }
+  [[nodiscard]] bool        isEmpty() const { return s_.empty(); }
+  bool                      reserve(const unsigned size) {
+    s_.reserve(size);
+    return true;
+  }
+
+  bool concat(const char* s) {
+    s_ += s != nullptr ? s : "";
+    return true;
+  }
+  bool concat(const char* s, const unsigned length) {
+    s_.append(s, length);
+    return true;
+  }
+  bool concat(const char c) {
+    s_ += c;
+    return true;
+  }
+  bool concat(const String& s) {
+    s_ += s.s_;
+    return true;
+  }
+  String& operator+=(const String& s) {
+    concat(s);
+    return *this;
+  }
+  String& operator+=(const char* s) {
+    concat(s);
+    return *this;
+  }
+  String& operator+=(const char c) {
+    concat(c);
+    return *this;
+  }
+
+  [[nodiscard]] char operator[](const unsigned index) const { return index < s_.size() ? s_[index] : '\0'; }
+  [[nodiscard]] int  indexOf(const char c, const unsigned from = 0) const { return position(s_.find(c, from)); }
+  [[nodiscard]] int  indexOf(const char* s, const unsigned from = 0) const { return position(s_.find(s, from)); }
+  [[nodiscard]] int  indexOf(const String& s, const unsigned from = 0) const { return position(s_.find(s.s_, from)); }
+  [[nodiscard]] String substring(const unsigned from) const { return from < s_.size() ? s_.substr(from) : ""; }
+  [[nodiscard]] String substring(const unsigned from, const unsigned to) const {
+    return from < to && from < s_.size() ? s_.substr(from, to - from) : "";
+  }
+  [[nodiscard]] bool startsWith(const char* prefix) const { return s_.rfind(prefix, 0) == 0; }
+  [[nodiscard]] bool startsWith(const String& prefix) const { return startsWith(prefix.c_str()); }
+  [[nodiscard]] bool endsWith(const char* suffix) const {
+    const size_t length = strlen(suffix);
+    return s_.size() >= length && s_.compare(s_.size() - length, length, suffix) == 0;
+  }
+  [[nodiscard]] long  toInt() const { return strtol(s_.c_str(), nullptr, 10); }
+  [[nodiscard]] float toFloat() const { return strtof(s_.c_str(), nullptr); }
+  void                trim() {
+    const size_t first = s_.find_first_not_of(" \t\r\n");
+    const size_t last  = s_.find_last_not_of(" \t\r\n");
+    s_                 = first == std::string::npos ? "" : s_.substr(first, last - first + 1);
+  }
+  void replace(const char* from, const char* to) {
+    const size_t length = strlen(from);
+    for (size_t at = s_.find(from); length > 0 && at != std::string::npos; at = s_.find(from, at + strlen(to)))
+      s_.replace(at, length, to);
+  }
+
+  bool operator==(const String& s) const { return s_ == s.s_; }
+  bool operator==(const char* s) const { return s_ == (s != nullptr ? s : ""); }
+  bool operator!=(const String& s) const { return !(*this == s); }
+  bool operator!=(const char* s) const { return !(*this == s); }
+
+  friend String operator+(const String& a, const String& b) { return a.s_ + b.s_; }
+  friend String operator+(const String& a, const char* b) { return a.s_ + b; }
+  friend String operator+(const char* a, const String& b) { return a + b.s_; }
+
+ private:
+  static int position(const size_t at) { return at == std::string::npos ? -1 : static_cast<int>(at); }
+
+  std::string s_;
+};
+
+// the type of `String + ...` in the Arduino core, ArduinoJson names it
+class StringSumHelper : public String {
+ public:
+  using String::String;
+};
+
+class Print {
+ public:
+  virtual ~Print() = default;
+
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* data, size_t size) {
+    size_t written = 0;
+    while (size-- > 0)
+      written += write(*data++);
+    return written;
+  }
+  size_t write(const char* s) { return s != nullptr ? write(s, strlen(s)) : 0; }
+  size_t write(const char* data, const size_t size) { return write(reinterpret_cast<const uint8_t*>(data), size); }
+  virtual void flush() {}
+
+  size_t print(const char* s) { return write(s); }
+  size_t print(const String& s) { return write(s.c_str(), s.length()); }
+  size_t print(const char c) { return write(static_cast<uint8_t>(c)); }
+  size_t print(const int value, const int base = DEC) { return print(static_cast<long>(value), base); }
+  size_t print(const unsigned value, const int base = DEC) { return print(static_cast<unsigned long>(value), base); }
+  size_t print(const long value, const int base = DEC) {
+    return base == DEC ? printf("%ld", value) : print(static_cast<unsigned long>(value), base);
+  }
+  size_t print(const unsigned long value, const int base = DEC) { return printf(base == HEX ? "%lX" : "%lu", value); }
+  size_t print(const long long value, const int base = DEC) {
+    return base == DEC ? printf("%lld", value) : printf("%llX", static_cast<unsigned long long>(value));
+  }
+  size_t print(const unsigned long long value, const int base = DEC) {
+    return printf(base == HEX ? "%llX" : "%llu", value);
+  }
+  size_t print(const double value, const int decimals = 2) { return printf("%.*f", decimals, value); }
+
+  size_t println() { return write("\r\n"); }
+  template <typename T>
+  size_t println(const T& value) {
+    return print(value) + println();
+  }
+  template <typename T>
+  size_t println(const T& value, const int format) {
+    return print(value, format) + println();
+  }
+
+  size_t printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    va_list copy;
+    va_copy(copy, args);
+    char         buffer[256];
+    const int    length = vsnprintf(buffer, sizeof(buffer), format, args);
+    size_t       written;
+    if (length < 0) {
+      written = 0;
+    } else if (static_cast<size_t>(length) < sizeof(buffer)) {
+      written = write(buffer, length);
+    } else {
+      std::string large(length + 1, '\0');
+      vsnprintf(large.data(), large.size(), format, copy);
+      written = write(large.data(), length);
+    }
+    va_end(copy);
+    va_end(args);
+    return written;
+  }
+};
+
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read()      = 0;
+  virtual int peek()      = 0;
+
+  void setTimeout(const unsigned long timeoutMs) { timeoutMs_ = timeoutMs; }
+
+  size_t readBytes(char* buffer, const size_t length) {
+    size_t count = 0;
+    for (int c; count < length && (c = timedRead()) >= 0;)
+      buffer[count++] = static_cast<char>(c);
+    return count;
+  }
+  size_t readBytes(uint8_t* buffer, const size_t length) { return readBytes(reinterpret_cast<char*>(buffer), length); }
+  String readStringUntil(const char terminator) {
+    std::string s;
+    for (int c; (c = timedRead()) >= 0 && c != terminator;)
+      s += static_cast<char>(c);
+    return s;
+  }
+
+ protected:
+  int timedRead() {
+    const unsigned long start = millis();
+    do {
+      const int c = read();
+      if (c >= 0)
+        return c;
+      yield();
+    } while (millis() - start < timeoutMs_);
+    return -1;
+  }
+
+  unsigned long timeoutMs_ = 1000;
+};
+
+class EspClass {
+ public:
+  // cycles of a 240 MHz core, for code timed with the cycle counter
+  uint32_t getCycleCount() { return static_cast<uint32_t>(micros() * 240); }
+  uint32_t getFreeHeap() { return 0; }
+  [[noreturn]] void restart() { exit(0); }
+};
+inline EspClass ESP;
+
+#include "HardwareSerial.h"
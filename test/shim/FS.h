@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Arduino.h"
+
+// a file that is never open, see LittleFS.h
+class File : public Stream {
+ public:
+  int    available() override { return 0; }
+  int    read() override { return -1; }
+  int    peek() override { return -1; }
+  size_t write(uint8_t) override { return 0; }
+  using Print::write;
+  size_t read(uint8_t*, size_t) { return 0; }
+  bool   seek(uint32_t) { return false; }
+  size_t position() const { return 0; }
+  size_t size() const { return 0; }
+  void   close() {}
+  File   openNextFile() { return {}; }
+  bool   isDirectory() const { return false; }
+  const char* name() const { return ""; }
+
+  explicit operator bool() const { return false; }
+};
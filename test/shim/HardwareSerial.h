@@ -0,0 +1,100 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+#include "Arduino.h"
+
+#define SERIAL_8N1 0x800001c
+
+/**
+ * UART on a host tty, e.g. the pseudo-terminal of tools/epever_emulator.py. setPort() (host only) names the tty that
+ * begin() opens; a UART without one writes to stdout and never receives, which is what Serial does.
+ */
+class HardwareSerial : public Stream {
+ public:
+  explicit HardwareSerial(const int uart) : uart_(uart) {}
+  ~HardwareSerial() override { end(); }
+
+  void setPort(const char* path) { path_ = path != nullptr ? path : ""; }
+
+  void begin(const unsigned long baud, uint32_t = SERIAL_8N1, int8_t = -1, int8_t = -1) {
+    end();
+    if (path_.empty())
+      return;
+    fd_ = open(path_.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd_ < 0) {
+      fprintf(stderr, "[HardwareSerial] UART%d: cannot open %s\n", uart_, path_.c_str());
+      return;
+    }
+    termios tty{};
+    tcgetattr(fd_, &tty);
+    cfmakeraw(&tty);
+    cfsetspeed(&tty, baud == 9600 ? B9600 : baud == 19200 ? B19200 : baud == 38400 ? B38400 : B115200);
+    tcsetattr(fd_, TCSANOW, &tty);
+    tcflush(fd_, TCIOFLUSH);
+  }
+  void end() {
+    if (fd_ >= 0)
+      close(fd_);
+    fd_   = -1;
+    peek_ = -1;
+  }
+
+  int available() override {
+    if (fd_ < 0)
+      return 0;
+    int pending = 0;
+    ioctl(fd_, FIONREAD, &pending);
+    return pending + (peek_ >= 0 ? 1 : 0);
+  }
+  int read() override {
+    const int c = peek();
+    peek_       = -1;
+    return c;
+  }
+  int peek() override {
+    uint8_t c;
+    if (peek_ < 0 && fd_ >= 0 && ::read(fd_, &c, 1) == 1)
+      peek_ = c;
+    return peek_;
+  }
+
+  size_t write(const uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* data, const size_t size) override {
+    if (fd_ < 0)
+      return fwrite(data, 1, size, stdout);
+    size_t written = 0;
+    while (written < size) {
+      const ssize_t result = ::write(fd_, data + written, size - written);
+      if (result > 0)
+        written += result;
+      else if (result < 0 && errno != EAGAIN)
+        break;
+    }
+    return written;
+  }
+  using Print::write;
+  void flush() override {
+    if (fd_ >= 0)
+      tcdrain(fd_);
+    else
+      fflush(stdout);
+  }
+
+  explicit operator bool() const { return true; }
+
+ private:
+  int         uart_;
+  std::string path_;
+  int         fd_   = -1;
+  int         peek_ = -1;
+};
+
+inline HardwareSerial Serial(0);
+inline HardwareSerial Serial1(1);
+inline HardwareSerial Serial2(2);
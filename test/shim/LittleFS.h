@@ -0,0 +1,18 @@
+#pragma once
+
+#include "FS.h"
+
+/**
+ * Mount point only: the native environment keeps the log in the partition store (MPPT_LOG_PARTITION), so nothing
+ * opens files; begin() succeeds and the file system is empty.
+ */
+class LittleFSFS {
+ public:
+  bool begin(bool = false) { return true; }
+  void end() {}
+  bool exists(const char*) { return false; }
+  bool remove(const char*) { return false; }
+  bool mkdir(const char*) { return true; }
+  File open(const char*, const char* = "r", bool = false) { return {}; }
+};
+inline LittleFSFS LittleFS;
@@ -0,0 +1,32 @@
+#pragma once
+
+/**
+ * The application objects main.cpp defines, for the host test suites: include it from exactly one file of a suite.
+ * The modem is a NativeCommunication that does no I/O; a suite sets `modemComesUp` to have its setup succeed.
+ */
+
+#include "ICommunicationService.h"
+#include "LoadController.h"
+#include "SleepManager.h"
+#include "TimeService.h"
+
+class NativeCommunication final : public ICommunicationService {
+ public:
+  void downloadConfig() override {}
+  void sendMPPTPayload(UploadFormat) override {}
+  void performOtaUpdate() override {}
+
+  bool modemComesUp = false;
+
+ protected:
+  bool setupModemImpl() override { return modemComesUp; }
+  void powerOffModemImpl() override {}
+};
+
+NativeCommunication    nativeCommunication;
+ICommunicationService* communicationService = &nativeCommunication;
+SleepManager           sleepManager;
+HardwareSerial         RS485Serial(2);
+ModbusRtuMaster        node;
+TimeService            timeService;
+LoadController         loadController;
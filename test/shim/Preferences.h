@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Arduino.h"
+
+/**
+ * NVS Preferences kept in memory for the life of the process. native::resetPreferences() forgets everything, like a
+ * freshly erased NVS partition.
+ */
+namespace native {
+inline std::map<std::string, std::vector<uint8_t>>& preferences() {
+  static std::map<std::string, std::vector<uint8_t>> entries;
+  return entries;
+}
+inline void resetPreferences() {
+  preferences().clear();
+}
+}  // namespace native
+
+class Preferences {
+ public:
+  bool begin(const char* name, const bool readOnly = false) {
+    namespace_ = name;
+    readOnly_  = readOnly;
+    return true;
+  }
+  void end() { namespace_.clear(); }
+
+  size_t putBytes(const char* key, const void* value, const size_t length) {
+    if (readOnly_)
+      return 0;
+    const auto* bytes = static_cast<const uint8_t*>(value);
+    native::preferences()[namespace_ + "/" + key].assign(bytes, bytes + length);
+    return length;
+  }
+  size_t getBytes(const char* key, void* buffer, const size_t maxLength) const {
+    const auto entry = native::preferences().find(namespace_ + "/" + key);
+    if (entry == native::preferences().end() || entry->second.size() > maxLength)
+      return 0;
+    memcpy(buffer, entry->second.data(), entry->second.size());
+    return entry->second.size();
+  }
+
+  size_t   putUChar(const char* key, const uint8_t value) { return putBytes(key, &value, sizeof(value)); }
+  size_t   putUInt(const char* key, const uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+  size_t   putULong(const char* key, const uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+  size_t   putULong64(const char* key, const uint64_t value) { return putBytes(key, &value, sizeof(value)); }
+  uint8_t  getUChar(const char* key, const uint8_t defaultValue = 0) const { return get(key, defaultValue); }
+  uint32_t getUInt(const char* key, const uint32_t defaultValue = 0) const { return get(key, defaultValue); }
+  uint32_t getULong(const char* key, const uint32_t defaultValue = 0) const { return get(key, defaultValue); }
+  uint64_t getULong64(const char* key, const uint64_t defaultValue = 0) const { return get(key, defaultValue); }
+
+  bool remove(const char* key) { return !readOnly_ && native::preferences().erase(namespace_ + "/" + key) > 0; }
+  bool isKey(const char* key) const { return native::preferences().count(namespace_ + "/" + key) > 0; }
+
+ private:
+  template <typename T>
+  T get(const char* key, const T defaultValue) const {
+    T value;
+    return getBytes(key, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+  }
+
+  std::string namespace_;
+  bool        readOnly_ = true;
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32 (IEEE 802.3) like the ROM function: crc32_le(0, ...) starts a CRC, passing a result continues it
+inline uint32_t crc32_le(uint32_t crc, const uint8_t* data, size_t length) {
+  crc = ~crc;
+  while (length-- > 0) {
+    crc ^= *data++;
+    for (int bit = 0; bit < 8; ++bit)
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+// RTC memory is ordinary memory on the host, it lives as long as the process
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define IRAM_ATTR
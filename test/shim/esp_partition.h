@@ -0,0 +1,122 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#define SPI_FLASH_SEC_SIZE 4096
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_SIZE 0x104
+
+typedef enum { ESP_PARTITION_TYPE_APP = 0x00, ESP_PARTITION_TYPE_DATA = 0x01 } esp_partition_type_t;
+typedef enum { ESP_PARTITION_SUBTYPE_ANY = 0xff } esp_partition_subtype_t;
+
+typedef struct {
+  esp_partition_type_t    type;
+  esp_partition_subtype_t subtype;
+  uint32_t                address;
+  uint32_t                size;
+  char                    label[17];
+  bool                    encrypted;
+} esp_partition_t;
+
+/**
+ * Data partition backed by a memory-mapped file, with NOR flash semantics: erasing sets whole sectors to 0xFF and a
+ * write can only clear bits, so writing over data that was not erased reads back corrupted, as on the chip. The file
+ * keeps the contents between runs like the flash keeps them across resets.
+ */
+namespace native {
+struct MappedPartition {
+  esp_partition_t partition{};
+  uint8_t*        data = nullptr;
+};
+
+inline MappedPartition& mappedPartition() {
+  static MappedPartition mapped;
+  return mapped;
+}
+
+inline void unmapPartition() {
+  MappedPartition& mapped = mappedPartition();
+  if (mapped.data != nullptr)
+    munmap(mapped.data, mapped.partition.size);
+  mapped = {};
+}
+
+// maps `path` as the data partition `label`; a new or shorter file is grown to `size` bytes of erased flash
+inline bool mapPartition(const char* label, const char* path, const uint32_t size) {
+  unmapPartition();
+  const int fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    perror(path);
+    return false;
+  }
+  const off_t existing = lseek(fd, 0, SEEK_END);
+  if (existing < static_cast<off_t>(size) && ftruncate(fd, size) != 0) {
+    close(fd);
+    return false;
+  }
+  void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return false;
+
+  MappedPartition& mapped = mappedPartition();
+  mapped.data             = static_cast<uint8_t*>(data);
+  if (existing < static_cast<off_t>(size))
+    memset(mapped.data + existing, 0xFF, size - existing);
+  mapped.partition.type    = ESP_PARTITION_TYPE_DATA;
+  mapped.partition.subtype = ESP_PARTITION_SUBTYPE_ANY;
+  mapped.partition.size    = size;
+  strncpy(mapped.partition.label, label, sizeof(mapped.partition.label) - 1);
+  return true;
+}
+
+inline bool inRange(const esp_partition_t* partition, const size_t offset, const size_t size) {
+  return partition == &mappedPartition().partition && offset <= partition->size && size <= partition->size - offset;
+}
+}  // namespace native
+
+inline const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t,
+                                                       const char* label) {
+  const native::MappedPartition& mapped = native::mappedPartition();
+  if (mapped.data == nullptr || mapped.partition.type != type || strcmp(mapped.partition.label, label) != 0)
+    return nullptr;
+  return &mapped.partition;
+}
+
+inline esp_err_t esp_partition_read(const esp_partition_t* partition, const size_t offset, void* dst,
+                                    const size_t size) {
+  if (!native::inRange(partition, offset, size))
+    return ESP_ERR_INVALID_ARG;
+  memcpy(dst, native::mappedPartition().data + offset, size);
+  return ESP_OK;
+}
+
+inline esp_err_t esp_partition_write(const esp_partition_t* partition, const size_t offset, const void* src,
+                                     const size_t size) {
+  if (!native::inRange(partition, offset, size))
+    return ESP_ERR_INVALID_ARG;
+  uint8_t*       flash = native::mappedPartition().data + offset;
+  const uint8_t* bytes = static_cast<const uint8_t*>(src);
+  for (size_t i = 0; i < size; ++i)
+    flash[i] &= bytes[i];
+  return ESP_OK;
+}
+
+inline esp_err_t esp_partition_erase_range(const esp_partition_t* partition, const size_t offset, const size_t size) {
+  if (!native::inRange(partition, offset, size))
+    return ESP_ERR_INVALID_ARG;
+  if (offset % SPI_FLASH_SEC_SIZE != 0 || size % SPI_FLASH_SEC_SIZE != 0)
+    return ESP_ERR_INVALID_SIZE;
+  memset(native::mappedPartition().data + offset, 0xFF, size);
+  return ESP_OK;
+}
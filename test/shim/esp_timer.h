@@ -0,0 +1,12 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "Arduino.h"
+
+// microseconds since boot, the epoch of micros()
+inline int64_t esp_timer_get_time() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - native::bootTime)
+      .count();
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+typedef int      BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY 0xFFFFFFFF
+#define portTICK_PERIOD_MS 1
+
+inline BaseType_t xPortGetCoreID() {
+  return 1;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+typedef uint32_t  EventBits_t;
+typedef uint32_t* EventGroupHandle_t;
+
+// bits of a single thread: waiting runs the deferred tasks, then returns the current bits
+inline EventGroupHandle_t xEventGroupCreate() {
+  return new uint32_t(0);
+}
+inline EventBits_t xEventGroupSetBits(EventGroupHandle_t group, const EventBits_t bits) {
+  return *group |= bits;
+}
+inline EventBits_t xEventGroupClearBits(EventGroupHandle_t group, const EventBits_t bits) {
+  const EventBits_t previous = *group;
+  *group &= ~bits;
+  return previous;
+}
+inline EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+  return *group;
+}
+inline EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, const EventBits_t bits, const BaseType_t clearOnExit,
+                                       BaseType_t, TickType_t) {
+  native::runPendingTasks();
+  const EventBits_t current = *group;
+  if (clearOnExit)
+    *group &= ~bits;
+  return current;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "FreeRTOS.h"
+
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+/**
+ * One core, no scheduler. By default creating a task fails, so callers take their inline path. With deferTasks set a
+ * created task only runs when something waits for it (xEventGroupWaitBits), which stands in for a task running on the
+ * other core until it is joined.
+ */
+namespace native {
+inline bool deferTasks = false;
+
+inline std::vector<std::pair<TaskFunction_t, void*>>& pendingTasks() {
+  static std::vector<std::pair<TaskFunction_t, void*>> tasks;
+  return tasks;
+}
+
+inline void runPendingTasks() {
+  std::vector<std::pair<TaskFunction_t, void*>> tasks;
+  tasks.swap(pendingTasks());
+  for (const auto& task : tasks)
+    task.first(task.second);
+}
+}  // namespace native
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char*, uint32_t, void* parameter, UBaseType_t,
+                                          TaskHandle_t* handle, BaseType_t) {
+  if (!native::deferTasks)
+    return pdFAIL;
+  native::pendingTasks().emplace_back(task, parameter);
+  if (handle != nullptr)
+    *handle = reinterpret_cast<TaskHandle_t>(task);
+  return pdPASS;
+}
+inline void vTaskDelete(TaskHandle_t) {}
+inline void vTaskDelay(TickType_t) {}
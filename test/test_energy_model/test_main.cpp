@@ -0,0 +1,161 @@
+#include <unity.h>
+
+#include <initializer_list>
+#include <utility>
+
+#include "EnergyModel.h"
+#include "NativeApp.h"
+
+/**
+ * EnergyModel and EnergyLedger against scripted wake traces: the phases a wake runs through, in order, with their
+ * durations, as WakeProfiler sums them up. Currents are round numbers so the expected charges can be read off the
+ * trace.
+ */
+
+namespace {
+constexpr EnergyCurrents CURRENTS      = {40, 100, 200, 10, 1};
+constexpr uint32_t       SLEEP_SECONDS = 120;
+constexpr time_t         DAY_START     = 1753228800;  // 2025-07-23 00:00 UTC
+constexpr float          SUPPLY_VOLTS  = ENERGY_SUPPLY_VOLTAGE;
+
+using Step  = std::pair<WakePhase, uint32_t>;  // phase and its duration in ms
+using Trace = uint32_t[WAKE_PHASE_COUNT];
+
+// sums the steps per phase in microseconds, as WakeProfiler::lastWakeUs() reports them
+void script(Trace& phaseUs, const std::initializer_list<Step> steps) {
+  for (uint32_t& us : phaseUs)
+    us = 0;
+  for (const Step& step : steps)
+    phaseUs[static_cast<size_t>(step.first)] += step.second * 1000;
+}
+
+// wake without the modem: poll the MPPT, append the sample to the log and sleep again
+void sampleOnlyWake(Trace& phaseUs) {
+  script(phaseUs, {{WakePhase::WakeSetup, 5},
+                   {WakePhase::LoadSetup, 1},
+                   {WakePhase::ModbusPoll, 250},
+                   {WakePhase::StoreOpen, 2},
+                   {WakePhase::LogAppend, 3},
+                   {WakePhase::ModbusPoll, 50},
+                   {WakePhase::SleepEntry, 1},
+                   {WakePhase::Awake, 500}});
+}
+
+// upload wake: the modem registers in its task while loop() polls and logs, then waits for it and transfers
+void uploadWake(Trace& phaseUs) {
+  script(phaseUs, {{WakePhase::WakeSetup, 5},
+                   {WakePhase::ModemSetup, 20000},
+                   {WakePhase::ModbusPoll, 300},
+                   {WakePhase::LogAppend, 200},
+                   {WakePhase::ModemWait, 19000},
+                   {WakePhase::ConfigDownload, 2000},
+                   {WakePhase::OtaUpdate, 1000},
+                   {WakePhase::Upload, 4000},
+                   {WakePhase::SleepEntry, 1500},
+                   {WakePhase::Awake, 30000}});
+}
+
+float consumer(const WakeCharge& charge, const EnergyConsumer which) {
+  return charge.mAs[static_cast<size_t>(which)];
+}
+
+float mwh(const float mAs) {
+  return mAs * SUPPLY_VOLTS / 3600.0f;
+}
+}  // namespace
+
+void setUp() {
+  setenv("TZ", "UTC0", 1);
+  tzset();
+  isTimeInitializedFromModem = true;
+}
+void tearDown() {}
+
+void test_sample_only_wake_charges_cpu_rs485_and_sleep() {
+  Trace phaseUs;
+  sampleOnlyWake(phaseUs);
+  const WakeCharge charge = EnergyModel(CURRENTS).wakeCharge(phaseUs, SLEEP_SECONDS);
+
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 40 * 0.5f, consumer(charge, EnergyConsumer::Cpu));
+  TEST_ASSERT_EQUAL_FLOAT(0, consumer(charge, EnergyConsumer::ModemRegister));
+  TEST_ASSERT_EQUAL_FLOAT(0, consumer(charge, EnergyConsumer::ModemTransmit));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 10 * 0.3f, consumer(charge, EnergyConsumer::Rs485));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 1 * 120.0f, consumer(charge, EnergyConsumer::DeepSleep));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 20 + 3 + 120, charge.total());
+}
+
+void test_upload_wake_splits_the_modem_into_register_and_transmit() {
+  Trace phaseUs;
+  uploadWake(phaseUs);
+  const WakeCharge charge = EnergyModel(CURRENTS).wakeCharge(phaseUs, SLEEP_SECONDS);
+
+  TEST_ASSERT_FLOAT_WITHIN(1e-2f, 40 * 30.0f, consumer(charge, EnergyConsumer::Cpu));
+  // registering overlaps the poll, the log append and the wait, and lasts until the modem is off at sleep entry
+  TEST_ASSERT_FLOAT_WITHIN(1e-2f, 100 * (0.3f + 0.2f + 19.0f + 1.5f), consumer(charge, EnergyConsumer::ModemRegister));
+  TEST_ASSERT_FLOAT_WITHIN(1e-2f, 200 * (2.0f + 1.0f + 4.0f), consumer(charge, EnergyConsumer::ModemTransmit));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 10 * 0.3f, consumer(charge, EnergyConsumer::Rs485));
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, 120.0f, consumer(charge, EnergyConsumer::DeepSleep));
+}
+
+void test_charge_converts_to_milliwatt_hours() {
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 3.7f, EnergyModel::toMilliwattHours(3600, 3.7f));
+  TEST_ASSERT_EQUAL_FLOAT(0, EnergyModel::toMilliwattHours(0, 3.7f));
+}
+
+void test_ledger_sums_the_wakes_of_a_day() {
+  Trace sample, upload;
+  sampleOnlyWake(sample);
+  uploadWake(upload);
+  const EnergyModel model(CURRENTS);
+  const WakeCharge  sampleCharge = model.wakeCharge(sample, SLEEP_SECONDS);
+  const WakeCharge  uploadCharge = model.wakeCharge(upload, SLEEP_SECONDS);
+
+  // a day of its own, so totals of earlier tests are dropped
+  EnergyLedger::addWake(uploadCharge, DAY_START + 60);
+  for (int i = 1; i <= 5; ++i)
+    EnergyLedger::addWake(sampleCharge, DAY_START + 60 + i * SLEEP_SECONDS);
+
+  const EnergySummary summary = EnergyLedger::summary();
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, sampleCharge.total(), summary.wakeMas);
+  for (size_t i = 0; i < ENERGY_CONSUMER_COUNT; ++i)
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, mwh(uploadCharge.mAs[i] + 5 * sampleCharge.mAs[i]), summary.todayMwh[i]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-3f, mwh(uploadCharge.total() + 5 * sampleCharge.total()), summary.todayTotalMwh());
+}
+
+void test_ledger_restarts_at_midnight() {
+  Trace sample, upload;
+  sampleOnlyWake(sample);
+  uploadWake(upload);
+  const EnergyModel model(CURRENTS);
+
+  EnergyLedger::addWake(model.wakeCharge(upload, SLEEP_SECONDS), DAY_START + 86400 - 30);
+  const WakeCharge nextDay = model.wakeCharge(sample, SLEEP_SECONDS);
+  EnergyLedger::addWake(nextDay, DAY_START + 86400 + 90);
+
+  const EnergySummary summary = EnergyLedger::summary();
+  TEST_ASSERT_EQUAL_FLOAT(0, summary.todayMwh[static_cast<size_t>(EnergyConsumer::ModemRegister)]);
+  TEST_ASSERT_EQUAL_FLOAT(0, summary.todayMwh[static_cast<size_t>(EnergyConsumer::ModemTransmit)]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, mwh(nextDay.total()), summary.todayTotalMwh());
+}
+
+void test_ledger_keeps_summing_until_the_clock_is_set() {
+  Trace sample;
+  sampleOnlyWake(sample);
+  const WakeCharge charge = EnergyModel(CURRENTS).wakeCharge(sample, SLEEP_SECONDS);
+
+  EnergyLedger::addWake(charge, DAY_START + 2 * 86400);
+  isTimeInitializedFromModem = false;
+  EnergyLedger::addWake(charge, 0);  // RTC not set yet: no day boundary to go by
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, mwh(2 * charge.total()), EnergyLedger::summary().todayTotalMwh());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_sample_only_wake_charges_cpu_rs485_and_sleep);
+  RUN_TEST(test_upload_wake_splits_the_modem_into_register_and_transmit);
+  RUN_TEST(test_charge_converts_to_milliwatt_hours);
+  RUN_TEST(test_ledger_sums_the_wakes_of_a_day);
+  RUN_TEST(test_ledger_restarts_at_midnight);
+  RUN_TEST(test_ledger_keeps_summing_until_the_clock_is_set);
+  return UNITY_END();
+}
@@ -0,0 +1,199 @@
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unity.h>
+
+#include "BufferPrint.h"
+#include "NativeApp.h"
+#include "SolarMPPTMonitor.h"
+
+/**
+ * One wake's Modbus traffic against tools/epever_emulator.py: the battery check of setLoadBasedOnConfig() followed by
+ * readLogsFromMPPT(), as loop() runs them. Reports the transactions and the cycle time of the wake. Then the re-read
+ * after a load switch, and the read windows against an emulator with --strict-map that rejects the unused addresses
+ * they bridge.
+ *
+ * The test starts the emulator itself (MPPT_EPEVER_EMULATOR, default tools/epever_emulator.py) on a clean link. With
+ * MPPT_RS485_PORT set it uses an emulator that is already running on that tty instead, e.g. one injecting faults, and
+ * only reports the figures.
+ */
+
+namespace {
+constexpr char LINK[] = "/tmp/mppt_native_rs485";
+
+pid_t emulator = -1;
+bool  linked   = false;
+bool  ownLink  = false;
+
+// option: an extra emulator flag, or nullptr
+const char* startEmulator(const char* option = nullptr) {
+  const char* script = getenv("MPPT_EPEVER_EMULATOR");
+  if (script == nullptr)
+    script = "tools/epever_emulator.py";
+  if (access(script, R_OK) != 0)
+    return nullptr;
+
+  unlink(LINK);
+  emulator = fork();
+  if (emulator == 0) {
+    execlp("python3", "python3", script, "--link", LINK, option, static_cast<char*>(nullptr));
+    _exit(127);
+  }
+  for (int i = 0; i < 50 && access(LINK, F_OK) != 0; ++i)
+    delay(100);
+  return access(LINK, F_OK) == 0 ? LINK : nullptr;
+}
+
+void stopEmulator() {
+  if (emulator > 0) {
+    kill(emulator, SIGTERM);
+    waitpid(emulator, nullptr, 0);
+  }
+  emulator = -1;
+}
+
+uint32_t jsonNumber(const char* json, const char* key) {
+  const char* at = strstr(json, key);
+  return at != nullptr ? strtoul(at + strlen(key), nullptr, 10) : UINT32_MAX;
+}
+
+uint32_t linkCounter(const LogEntry& entry, const char* key) {
+  uint8_t     buffer[LogEntry::MAX_PRINT_LENGTH + 1];
+  BufferPrint out(buffer, sizeof(buffer) - 1);
+  entry.printJson(out);
+  buffer[out.length()] = '\0';
+  return jsonNumber(strstr(reinterpret_cast<const char*>(buffer), "\"rs485\":"), key);
+}
+
+uint32_t transactions(const LogEntry& entry) {
+  return linkCounter(entry, "\"tx\":");
+}
+
+// windows of the read plan holding a register of `mask`, only those spanning unused addresses with `gapsOnly`
+uint32_t windowsHolding(uint64_t mask, bool gapsOnly) {
+  uint32_t windows = 0;
+  for (size_t w = 0; w < mpptReadPlan.windowCount; ++w) {
+    bool     holds = false;
+    uint32_t words = 0;
+    for (size_t i = 0; i < mpptReadRegistersCount; ++i) {
+      if (mpptReadPlan.slots[i].window != w)
+        continue;
+      holds |= (mask >> i & 1) != 0;
+      words += registerWords(mpptReadRegisters[i]);
+    }
+    windows += holds && (!gapsOnly || words < mpptReadPlan.windows[w].count);
+  }
+  return windows;
+}
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_wake_reads_every_register() {
+  const char* port = getenv("MPPT_RS485_PORT");
+  ownLink          = port == nullptr;
+  if (ownLink)
+    port = startEmulator();
+  if (port == nullptr)
+    TEST_IGNORE_MESSAGE("EPever emulator not available, set MPPT_EPEVER_EMULATOR or MPPT_RS485_PORT");
+
+  linked = true;
+  RS485Serial.setPort(port);
+  SolarMPPTMonitor::initOrResetRS485(false);
+
+  const uint32_t start = micros();
+  float          soc, temperature;
+  SolarMPPTMonitor::readBatteryStatus(soc, temperature);
+  const LogEntry entry   = SolarMPPTMonitor::readLogsFromMPPT();
+  const uint32_t cycleUs = micros() - start;
+
+  uint8_t     buffer[LogEntry::MAX_PRINT_LENGTH + 1];
+  BufferPrint out(buffer, sizeof(buffer) - 1);
+  entry.printJson(out);
+  buffer[out.length()] = '\0';
+
+  const char*    json = reinterpret_cast<const char*>(buffer);
+  const uint32_t tx   = jsonNumber(json, "\"rs485\":{\"tx\":");
+
+  char report[128];
+  snprintf(report, sizeof(report), "wake: %u transactions, %u windows planned, cycle %.1f ms", tx,
+           static_cast<unsigned>(mpptReadPlan.windowCount), cycleUs / 1000.0);
+  TEST_MESSAGE(report);
+
+  for (size_t i = 0; i < mpptReadRegistersCount; ++i) {
+    char key[RegisterJsonKey::LENGTH + 1];
+    memcpy(key, mpptRegisterJsonKeys[i].text, sizeof(key));
+    TEST_ASSERT_NOT_NULL(strstr(json, key));
+  }
+  if (ownLink) {
+    // one transaction per read window and one for the load coil, the battery check's poll is reused
+    TEST_ASSERT_EQUAL_UINT32(mpptReadPlan.windowCount + 1, tx);
+    TEST_ASSERT_EQUAL_UINT32(0, jsonNumber(json, "\"crc\":"));
+    TEST_ASSERT_EQUAL_UINT32(0, jsonNumber(json, "\"timeout\":"));
+  }
+}
+
+void test_second_poll_is_served_from_the_snapshot() {
+  if (!linked)
+    TEST_IGNORE_MESSAGE("EPever emulator not available");
+  const LogEntry first  = SolarMPPTMonitor::readLogsFromMPPT();
+  const LogEntry second = SolarMPPTMonitor::readLogsFromMPPT();
+
+  uint8_t     a[LogEntry::MAX_PRINT_LENGTH + 1], b[LogEntry::MAX_PRINT_LENGTH + 1];
+  BufferPrint outA(a, sizeof(a) - 1), outB(b, sizeof(b) - 1);
+  first.printJson(outA);
+  second.printJson(outB);
+  a[outA.length()] = '\0';
+  b[outB.length()] = '\0';
+  TEST_ASSERT_EQUAL_UINT32(jsonNumber(reinterpret_cast<const char*>(a), "\"rs485\":{\"tx\":"),
+                           jsonNumber(reinterpret_cast<const char*>(b), "\"rs485\":{\"tx\":"));
+}
+
+void test_switching_the_load_rereads_the_load_registers() {
+  if (!linked || !ownLink)
+    TEST_IGNORE_MESSAGE("needs the emulator on a clean link");
+  int loadState;
+  TEST_ASSERT_TRUE(SolarMPPTMonitor::readLoadState(loadState));
+  const uint32_t before = transactions(SolarMPPTMonitor::readLogsFromMPPT());
+  TEST_ASSERT_TRUE(SolarMPPTMonitor::setLoad(loadState == 0));
+  const LogEntry after = SolarMPPTMonitor::readLogsFromMPPT();
+
+  // the coil write, the coil read back, and the windows holding a register that follows the load output
+  TEST_ASSERT_EQUAL_UINT32(before + 2 + windowsHolding(LOAD_REGISTER_MASK, false), transactions(after));
+}
+
+void test_rejected_windows_are_read_in_parts() {
+  if (!linked || !ownLink)
+    TEST_IGNORE_MESSAGE("needs the emulator on a clean link");
+  // a controller answering illegal data address for unmapped registers
+  stopEmulator();
+  TEST_ASSERT_NOT_NULL(startEmulator("--strict-map"));
+  SolarMPPTMonitor::initOrResetRS485(true);
+
+  int loadState;
+  TEST_ASSERT_TRUE(SolarMPPTMonitor::readLoadState(loadState));
+  TEST_ASSERT_TRUE(SolarMPPTMonitor::setLoad(loadState == 0));
+  const uint32_t exceptions = linkCounter(SolarMPPTMonitor::readLogsFromMPPT(), "\"exception\":");
+  TEST_ASSERT_TRUE(SolarMPPTMonitor::pollRegisters());
+
+  // the split windows are remembered: switching back re-reads their parts without another rejected request
+  TEST_ASSERT_TRUE(SolarMPPTMonitor::setLoad(loadState != 0));
+  const LogEntry after = SolarMPPTMonitor::readLogsFromMPPT();
+  TEST_ASSERT_TRUE(SolarMPPTMonitor::pollRegisters());
+  TEST_ASSERT_EQUAL_UINT32(exceptions, linkCounter(after, "\"exception\":"));
+  TEST_ASSERT_EQUAL_UINT32(0, linkCounter(after, "\"timeout\":"));
+  // one rejected request per window bridging unused addresses, the earlier tests ran against a lenient map
+  TEST_ASSERT_EQUAL_UINT32(windowsHolding(LOAD_REGISTER_MASK, true), exceptions);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_wake_reads_every_register);
+  RUN_TEST(test_second_poll_is_served_from_the_snapshot);
+  RUN_TEST(test_switching_the_load_rereads_the_load_registers);
+  RUN_TEST(test_rejected_windows_are_read_in_parts);
+  const int failures = UNITY_END();
+  stopEmulator();
+  return failures;
+}
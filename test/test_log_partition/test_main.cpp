@@ -0,0 +1,191 @@
+#include <esp_partition.h>
+#include <esp_system.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unity.h>
+
+#include <functional>
+#include <vector>
+
+#include "BufferPrint.h"
+#include "LoggingService.h"
+#include "NativeApp.h"
+
+/**
+ * The circular log of LogStorePartition.cpp on a memory-mapped file. Every boot of the board runs in a child process
+ * of its own: the file keeps the flash contents, RTC memory and NVS start out empty like after a power loss.
+ */
+
+namespace {
+constexpr char     PARTITION_FILE[]  = "/tmp/mppt_native_log.bin";
+constexpr uint32_t SECTORS           = 4;
+constexpr uint32_t PARTITION_SIZE    = SECTORS * SPI_FLASH_SEC_SIZE;
+constexpr uint32_t SLOT_SIZE         = 2 * sizeof(uint32_t) + sizeof(LogRecord);  // Slot of LogStorePartition.cpp
+constexpr uint32_t SLOTS_PER_SECTOR  = SPI_FLASH_SEC_SIZE / SLOT_SIZE;
+constexpr uint32_t FIRST_TS          = 1750000000;
+constexpr uint8_t  LEFTOVER_PATTERN  = 0xA5;
+
+using Timestamps = std::vector<uint32_t>;
+
+// runs one boot in a child process and returns the timestamps it reports
+Timestamps boot(const std::function<void(Timestamps&)>& body) {
+  int channel[2];
+  TEST_ASSERT_EQUAL(0, pipe(channel));
+  fflush(stdout);
+  const pid_t child = fork();
+  if (child == 0) {
+    close(channel[0]);
+    native::resetReason = ESP_RST_POWERON;
+    native::mapPartition(MPPT_LOG_PARTITION_LABEL, PARTITION_FILE, PARTITION_SIZE);
+    LoggingService::setup();
+    Timestamps report;
+    body(report);
+    native::unmapPartition();
+    const bool sent = write(channel[1], report.data(), report.size() * sizeof(uint32_t)) ==
+                      static_cast<ssize_t>(report.size() * sizeof(uint32_t));
+    _exit(sent ? 0 : 1);
+  }
+  close(channel[1]);
+  Timestamps report;
+  uint32_t   ts;
+  while (read(channel[0], &ts, sizeof(ts)) == sizeof(ts))
+    report.push_back(ts);
+  close(channel[0]);
+  int status = -1;
+  waitpid(child, &status, 0);
+  TEST_ASSERT_TRUE_MESSAGE(WIFEXITED(status) && WEXITSTATUS(status) == 0, "boot did not complete");
+  return report;
+}
+
+void append(const uint32_t firstTs, const uint32_t count) {
+  for (uint32_t i = 0; i < count; ++i)
+    LoggingService::logMPPTEntryToFile(LogEntry(firstTs + i, 0));
+  LoggingService::flushPendingSamples();
+}
+
+void readAll(Timestamps& report) {
+  LogReader reader(LoggingService::acknowledgedCursor());
+  LogEntry  entry;
+  while (reader.next(entry)) {
+    uint8_t     buffer[LogEntry::MAX_PRINT_LENGTH + 1];
+    BufferPrint out(buffer, sizeof(buffer) - 1);
+    entry.printJson(out);
+    buffer[out.length()] = '\0';
+    report.push_back(strtoul(reinterpret_cast<const char*>(buffer) + strlen("{\"ts\":"), nullptr, 10));
+  }
+}
+
+void assertRun(const Timestamps& report, const uint32_t firstTs, const uint32_t count) {
+  TEST_ASSERT_EQUAL_UINT32(count, report.size());
+  for (uint32_t i = 0; i < count; ++i)
+    TEST_ASSERT_EQUAL_UINT32(firstTs + i, report[i]);
+}
+
+// flash as another partition layout left it: nothing erased but sector 0
+void fillWithLeftovers() {
+  native::mapPartition(MPPT_LOG_PARTITION_LABEL, PARTITION_FILE, PARTITION_SIZE);
+  uint8_t* flash = native::mappedPartition().data;
+  memset(flash, LEFTOVER_PATTERN, PARTITION_SIZE);
+  memset(flash, 0xFF, SPI_FLASH_SEC_SIZE);
+  native::unmapPartition();
+}
+}  // namespace
+
+void setUp() {
+  unlink(PARTITION_FILE);
+}
+void tearDown() {
+  unlink(PARTITION_FILE);
+}
+
+void test_records_survive_a_reboot() {
+  boot([](Timestamps&) { append(FIRST_TS, 30); });
+  assertRun(boot(readAll), FIRST_TS, 30);
+}
+
+void test_appending_continues_mid_sector_after_a_reboot() {
+  boot([](Timestamps&) { append(FIRST_TS, 5); });
+  boot([](Timestamps&) { append(FIRST_TS + 5, 5); });
+  boot([](Timestamps&) { append(FIRST_TS + 10, SLOTS_PER_SECTOR); });
+  assertRun(boot(readAll), FIRST_TS, 10 + SLOTS_PER_SECTOR);
+}
+
+void test_wraparound_drops_the_oldest_sector() {
+  // one and a half sectors beyond the capacity, over several boots
+  const uint32_t total = (SECTORS + 1) * SLOTS_PER_SECTOR + SLOTS_PER_SECTOR / 2;
+  for (uint32_t written = 0; written < total; written += 7)
+    boot([&](Timestamps&) { append(FIRST_TS + written, std::min<uint32_t>(7, total - written)); });
+
+  // the sector being filled and the SECTORS - 1 full ones before it survive
+  const uint32_t surviving = (SECTORS - 1) * SLOTS_PER_SECTOR + SLOTS_PER_SECTOR / 2;
+  assertRun(boot(readAll), FIRST_TS + total - surviving, surviving);
+}
+
+void test_wraparound_with_sector_zero_erased() {
+  // power lost right after the erase of sector 0 that starts the second round
+  const uint32_t total = SECTORS * SLOTS_PER_SECTOR;
+  boot([&](Timestamps&) { append(FIRST_TS, total); });
+  native::mapPartition(MPPT_LOG_PARTITION_LABEL, PARTITION_FILE, PARTITION_SIZE);
+  esp_partition_erase_range(&native::mappedPartition().partition, 0, SPI_FLASH_SEC_SIZE);
+  native::unmapPartition();
+
+  boot([&](Timestamps&) { append(FIRST_TS + total, 3); });
+  assertRun(boot(readAll), FIRST_TS + SLOTS_PER_SECTOR, total - SLOTS_PER_SECTOR + 3);
+}
+
+void test_leftover_data_is_erased_instead_of_recovered() {
+  fillWithLeftovers();
+  TEST_ASSERT_EQUAL_UINT32(0, boot(readAll).size());
+
+  boot([](Timestamps&) { append(FIRST_TS, SLOTS_PER_SECTOR + 3); });
+  assertRun(boot(readAll), FIRST_TS, SLOTS_PER_SECTOR + 3);
+}
+
+void test_leftover_data_is_erased_when_the_log_looks_fresh() {
+  fillWithLeftovers();
+  native::mapPartition(MPPT_LOG_PARTITION_LABEL, PARTITION_FILE, PARTITION_SIZE);
+  memset(native::mappedPartition().data + (SECTORS - 1) * SPI_FLASH_SEC_SIZE, 0xFF, SPI_FLASH_SEC_SIZE);
+  native::unmapPartition();
+
+  // the log grows into sector 1 and would meet the leftovers in sector 2 at the next boot
+  boot([](Timestamps&) { append(FIRST_TS, SLOTS_PER_SECTOR + 3); });
+  boot([](Timestamps&) { append(FIRST_TS + SLOTS_PER_SECTOR + 3, 2); });
+  assertRun(boot(readAll), FIRST_TS, SLOTS_PER_SECTOR + 5);
+}
+
+void test_leftover_with_an_aligned_sequence_is_erased() {
+  fillWithLeftovers();
+  native::mapPartition(MPPT_LOG_PARTITION_LABEL, PARTITION_FILE, PARTITION_SIZE);
+  memset(native::mappedPartition().data, LEFTOVER_PATTERN, SPI_FLASH_SEC_SIZE);
+  memset(native::mappedPartition().data, 0, sizeof(uint32_t));  // reads as sequence 0 in slot 0
+  native::unmapPartition();
+
+  TEST_ASSERT_EQUAL_UINT32(0, boot(readAll).size());
+}
+
+void test_torn_newest_record_keeps_the_log() {
+  boot([](Timestamps&) { append(FIRST_TS, 5); });
+  // power lost while the fifth record was written: its tail is still erased
+  native::mapPartition(MPPT_LOG_PARTITION_LABEL, PARTITION_FILE, PARTITION_SIZE);
+  memset(native::mappedPartition().data + 4 * SLOT_SIZE + SLOT_SIZE / 2, 0xFF, SLOT_SIZE / 2);
+  native::unmapPartition();
+
+  boot([](Timestamps&) { append(FIRST_TS + 5, 1); });
+  const Timestamps report = boot(readAll);
+  TEST_ASSERT_EQUAL_UINT32(5, report.size());
+  assertRun(Timestamps(report.begin(), report.begin() + 4), FIRST_TS, 4);
+  TEST_ASSERT_EQUAL_UINT32(FIRST_TS + 5, report[4]);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_records_survive_a_reboot);
+  RUN_TEST(test_appending_continues_mid_sector_after_a_reboot);
+  RUN_TEST(test_wraparound_drops_the_oldest_sector);
+  RUN_TEST(test_wraparound_with_sector_zero_erased);
+  RUN_TEST(test_leftover_data_is_erased_instead_of_recovered);
+  RUN_TEST(test_leftover_data_is_erased_when_the_log_looks_fresh);
+  RUN_TEST(test_leftover_with_an_aligned_sequence_is_erased);
+  RUN_TEST(test_torn_newest_record_keeps_the_log);
+  return UNITY_END();
+}
@@ -0,0 +1,241 @@
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unity.h>
+
+#include "NativeApp.h"
+#include "PowerSavingGrant.h"
+
+/**
+ * Decoding of the PSM and eDRX grant: GPRS timer bytes, the extended +CEREG report with granted, rejected and absent
+ * timers, and +CEDRXRDP. The last tests run the AT dialog of CommunicationA7670E against tools/a7670_emulator.py
+ * (MPPT_A7670_EMULATOR, default tools/a7670_emulator.py), once with PSM granted and once with --reject-psm, and parse
+ * its answers the way readPowerSavingGrant() does.
+ */
+
+namespace {
+constexpr char LINK[] = "/tmp/mppt_native_modem";
+
+pid_t          emulator = -1;
+HardwareSerial modemSerial(1);
+
+// option: an extra emulator flag, or nullptr
+bool startEmulator(const char* option) {
+  const char* script = getenv("MPPT_A7670_EMULATOR");
+  if (script == nullptr)
+    script = "tools/a7670_emulator.py";
+  if (access(script, R_OK) != 0)
+    return false;
+
+  unlink(LINK);
+  emulator = fork();
+  if (emulator == 0) {
+    execlp("python3", "python3", script, "--link", LINK, "--boot-ms", "0", "--attach-ms", "0", "--latency-ms", "0",
+           option, static_cast<char*>(nullptr));
+    _exit(127);
+  }
+  for (int i = 0; i < 50 && access(LINK, F_OK) != 0; ++i)
+    delay(100);
+  if (access(LINK, F_OK) != 0)
+    return false;
+  modemSerial.setPort(LINK);
+  modemSerial.begin(115200);
+  modemSerial.setTimeout(1000);
+  return true;
+}
+
+void stopEmulator() {
+  modemSerial.end();
+  if (emulator > 0) {
+    kill(emulator, SIGTERM);
+    waitpid(emulator, nullptr, 0);
+  }
+  emulator = -1;
+}
+
+// sends one command, returns the text behind `prefix` of its answer like waitResponse(1000L, prefix) leaves it
+String command(const char* at, const char* prefix = nullptr) {
+  modemSerial.print(at);
+  modemSerial.print("\r");
+  String answer;
+  for (int i = 0; i < 8; ++i) {
+    String line = modemSerial.readStringUntil('\n');
+    line.trim();
+    if (line == "OK" || line == "ERROR" || (line.length() == 0 && modemSerial.available() == 0 && i > 0))
+      break;
+    if (prefix != nullptr && line.startsWith(prefix))
+      answer = line.substring(strlen(prefix));
+  }
+  return answer;
+}
+
+PowerSavingGrant requestAndReadGrant() {
+  command("AT");
+  command("AT+CPSMS=1,,,\"" MODEM_PSM_PERIODIC_TAU "\",\"" MODEM_PSM_ACTIVE_TIME "\"");
+  command("AT+CEDRXS=1,4,\"" MODEM_EDRX_CYCLE "\"");
+  command("AT+CEREG=4");
+
+  PowerSavingGrant grant;
+  TEST_ASSERT_TRUE(grant.parseRegistration(command("AT+CEREG?", "+CEREG:").c_str()));
+  TEST_ASSERT_TRUE(grant.parseEdrx(command("AT+CEDRXRDP", "+CEDRXRDP:").c_str()));
+  return grant;
+}
+
+PowerSavingGrant registration(const char* report) {
+  PowerSavingGrant grant;
+  TEST_ASSERT_TRUE(grant.parseRegistration(report));
+  return grant;
+}
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_timer_bits() {
+  TEST_ASSERT_EQUAL_HEX8(0x21, PowerSavingGrant::parseTimer("00100001"));
+  TEST_ASSERT_EQUAL_HEX8(0x05, PowerSavingGrant::parseTimer("00000101"));
+  TEST_ASSERT_EQUAL_HEX8(PowerSavingGrant::NOT_GRANTED, PowerSavingGrant::parseTimer("11100000"));
+  TEST_ASSERT_EQUAL_HEX8(PowerSavingGrant::NOT_GRANTED, PowerSavingGrant::parseTimer("11111111"));
+  TEST_ASSERT_EQUAL_HEX8(PowerSavingGrant::NOT_GRANTED, PowerSavingGrant::parseTimer(""));
+  TEST_ASSERT_EQUAL_HEX8(PowerSavingGrant::NOT_GRANTED, PowerSavingGrant::parseTimer("0010000"));
+  TEST_ASSERT_EQUAL_HEX8(PowerSavingGrant::NOT_GRANTED, PowerSavingGrant::parseTimer("001000011"));
+  TEST_ASSERT_EQUAL_HEX8(PowerSavingGrant::NOT_GRANTED, PowerSavingGrant::parseTimer("0010002 "));
+}
+
+void test_active_time_units() {
+  PowerSavingGrant grant;
+  grant.periodicTau = PowerSavingGrant::parseTimer("00100001");
+  const struct {
+    const char* bits;
+    uint32_t    seconds;
+  } cases[] = {
+      {"00000101", 10},        // 2 s units
+      {"00011111", 62},        // the value is five bits wide
+      {"00100001", 60},        // 1 min units
+      {"01000010", 720},       // 6 min units
+      {"01011111", 31 * 360},  // largest grant
+      {"01100011", 180},       // deprecated units count as 1 min
+      {"11000001", 60},
+  };
+  for (const auto& c : cases) {
+    grant.activeTime = PowerSavingGrant::parseTimer(c.bits);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(c.seconds, grant.activeTimeSeconds(), c.bits);
+  }
+}
+
+void test_periodic_tau_units() {
+  PowerSavingGrant grant;
+  grant.activeTime = PowerSavingGrant::parseTimer("00000101");
+  const struct {
+    const char* bits;
+    uint32_t    seconds;
+  } cases[] = {
+      {"00000110", 3600},            // 10 min units
+      {"00100001", 3600},            // 1 h units
+      {"01000010", 72000},           // 10 h units
+      {"01100101", 10},              // 2 s units
+      {"10000100", 120},             // 30 s units
+      {"10100011", 180},             // 1 min units
+      {"11000001", 1152000},         // 320 h units
+      {"11011111", 31 * 1152000u},   // largest grant
+  };
+  for (const auto& c : cases) {
+    grant.periodicTau = PowerSavingGrant::parseTimer(c.bits);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(c.seconds, grant.periodicTauSeconds(), c.bits);
+  }
+}
+
+void test_registration_with_both_timers_granted() {
+  const PowerSavingGrant grant = registration("+CEREG: 4,1,\"5A1E\",\"0B28A40A\",7,,,\"00000101\",\"00100001\"\r\n");
+  TEST_ASSERT_TRUE(grant.isRegistered());
+  TEST_ASSERT_TRUE(grant.isPsmGranted());
+  TEST_ASSERT_EQUAL_UINT32(10, grant.activeTimeSeconds());
+  TEST_ASSERT_EQUAL_UINT32(3600, grant.periodicTauSeconds());
+
+  // as readPowerSavingGrant() hands it over, behind the prefix waitResponse() consumed, roaming
+  const PowerSavingGrant roaming = registration(" 4,5,\"5A1E\",\"0B28A40A\",7,,,\"00000101\",\"00100001\"");
+  TEST_ASSERT_TRUE(roaming.isRegistered());
+  TEST_ASSERT_TRUE(roaming.isPsmGranted());
+}
+
+void test_rejected_or_absent_timers_are_not_a_grant() {
+  const char* reports[] = {
+      "+CEREG: 4,1,\"5A1E\",\"0B28A40A\",7,,,\"11100000\",\"11100000\"",  // rejected
+      "+CEREG: 4,1,\"5A1E\",\"0B28A40A\",7,,,\"00000101\",\"11100000\"",  // TAU rejected
+      "+CEREG: 4,1,\"5A1E\",\"0B28A40A\",7,,,\"11100000\",\"00100001\"",  // active time rejected
+      "+CEREG: 4,1,\"5A1E\",\"0B28A40A\",7,,,,",                          // empty
+      "+CEREG: 4,1,\"5A1E\",\"0B28A40A\",7",                              // absent
+      "+CEREG: 0,1",
+  };
+  for (const char* report : reports) {
+    const PowerSavingGrant grant = registration(report);
+    TEST_ASSERT_TRUE_MESSAGE(grant.isRegistered(), report);
+    TEST_ASSERT_FALSE_MESSAGE(grant.isPsmGranted(), report);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, grant.activeTimeSeconds(), report);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, grant.periodicTauSeconds(), report);
+  }
+}
+
+void test_registration_state() {
+  TEST_ASSERT_FALSE(registration("+CEREG: 4,2").isRegistered());  // searching
+  TEST_ASSERT_FALSE(registration("+CEREG: 4,3").isRegistered());  // denied
+  TEST_ASSERT_EQUAL_INT8(2, registration("+CEREG: 4,2").registration);
+
+  PowerSavingGrant grant;
+  TEST_ASSERT_FALSE(grant.parseRegistration("+CEREG: 4"));
+  TEST_ASSERT_FALSE(grant.parseRegistration("+CEREG: 4,"));
+  TEST_ASSERT_FALSE(grant.parseRegistration(""));
+  TEST_ASSERT_EQUAL_INT8(-1, grant.registration);
+}
+
+void test_edrx() {
+  PowerSavingGrant grant;
+  TEST_ASSERT_TRUE(grant.parseEdrx("+CEDRXRDP: 4,\"0101\",\"0101\",\"0011\""));
+  TEST_ASSERT_TRUE(grant.edrx);
+  TEST_ASSERT_TRUE(grant.parseEdrx("+CEDRXRDP: 4,\"0101\",,"));  // no network provided value
+  TEST_ASSERT_FALSE(grant.edrx);
+  grant.edrx = true;
+  TEST_ASSERT_TRUE(grant.parseEdrx(" 0"));  // not in use
+  TEST_ASSERT_FALSE(grant.edrx);
+  TEST_ASSERT_FALSE(grant.parseEdrx("+CEDRXRDP: "));
+}
+
+void test_emulator_grants_the_requested_timers() {
+  if (!startEmulator(nullptr))
+    TEST_IGNORE_MESSAGE("A7670E emulator not available, set MPPT_A7670_EMULATOR");
+  const PowerSavingGrant grant = requestAndReadGrant();
+  stopEmulator();
+
+  TEST_ASSERT_TRUE(grant.isRegistered());
+  TEST_ASSERT_TRUE(grant.isPsmGranted());
+  TEST_ASSERT_EQUAL_HEX8(PowerSavingGrant::parseTimer(MODEM_PSM_ACTIVE_TIME), grant.activeTime);
+  TEST_ASSERT_EQUAL_HEX8(PowerSavingGrant::parseTimer(MODEM_PSM_PERIODIC_TAU), grant.periodicTau);
+  TEST_ASSERT_TRUE(grant.edrx);
+}
+
+void test_emulator_rejecting_psm() {
+  if (!startEmulator("--reject-psm"))
+    TEST_IGNORE_MESSAGE("A7670E emulator not available, set MPPT_A7670_EMULATOR");
+  const PowerSavingGrant grant = requestAndReadGrant();
+  stopEmulator();
+
+  TEST_ASSERT_TRUE(grant.isRegistered());
+  TEST_ASSERT_FALSE(grant.isPsmGranted());
+  TEST_ASSERT_TRUE(grant.edrx);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_timer_bits);
+  RUN_TEST(test_active_time_units);
+  RUN_TEST(test_periodic_tau_units);
+  RUN_TEST(test_registration_with_both_timers_granted);
+  RUN_TEST(test_rejected_or_absent_timers_are_not_a_grant);
+  RUN_TEST(test_registration_state);
+  RUN_TEST(test_edrx);
+  RUN_TEST(test_emulator_grants_the_requested_timers);
+  RUN_TEST(test_emulator_rejecting_psm);
+  const int failures = UNITY_END();
+  stopEmulator();
+  return failures;
+}
@@ -0,0 +1,164 @@
+#include <unity.h>
+
+#include <chrono>
+
+#include "BufferPrint.h"
+#include "LoggingService.h"
+#include "NativeApp.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * Host microbenchmark of the two LogEntry serializers on a fully populated entry: LogEntry::printJson() into a fixed
+ * buffer, and the JsonDocument path (toDocument() + serializeJson() into a String) it replaced. Reports the time and,
+ * on x86, the TSC ticks per entry; the on-target cycle counts come from a firmware build with -DMPPT_SERIALIZER_BENCH.
+ * Both paths are checked against each other first, the WakeReport's as well.
+ */
+
+namespace {
+constexpr int ROUNDS = 20000;
+
+struct Cost {
+  double   ns;
+  uint64_t ticks;
+};
+
+uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+// per-call cost of `serialize` averaged over ROUNDS calls
+template <typename Serialize>
+Cost measure(Serialize serialize) {
+  for (int i = 0; i < ROUNDS / 10; ++i)
+    serialize();  // warm-up
+  const auto     start      = std::chrono::steady_clock::now();
+  const uint64_t startTicks = ticks();
+  for (int i = 0; i < ROUNDS; ++i)
+    serialize();
+  const uint64_t endTicks = ticks();
+  const auto     end      = std::chrono::steady_clock::now();
+  return {std::chrono::duration<double, std::nano>(end - start).count() / ROUNDS, (endTicks - startTicks) / ROUNDS};
+}
+
+// every register read with a value of its width, as after a complete poll
+LogEntry populatedEntry() {
+  LogEntry       entry(1753296102, 1);
+  RegisterValues values;
+  for (size_t i = 0; i < mpptReadRegistersCount; ++i)
+    values.set(i, 1261 + 37 * i);
+  entry.setValues(values);
+  LinkErrorCounters counters{};
+  counters.transactions = 4;
+  entry.setLinkCounters(counters);
+  return entry;
+}
+
+size_t streamJson(const LogEntry& entry, uint8_t (&buffer)[LogEntry::MAX_PRINT_LENGTH + 1]) {
+  BufferPrint out(buffer, LogEntry::MAX_PRINT_LENGTH);
+  const size_t length = entry.printJson(out);
+  buffer[out.length()] = '\0';
+  return length;
+}
+
+String documentJson(const LogEntry& entry) {
+  JsonDocument doc;
+  entry.toDocument(doc);
+  String out;
+  serializeJson(doc, out);
+  return out;
+}
+
+// a report with the last wake, a window and a day of energy
+WakeReport populatedReport() {
+  WakeReport report{};
+  report.ts = 1753296102;
+  for (size_t i = 0; i < WAKE_PHASE_COUNT; ++i) {
+    report.profile.lastMs[i] = 11 * (i + 1);
+    report.profile.minMs[i]  = 7 * (i + 1);
+    report.profile.meanMs[i] = 13 * (i + 1);
+    report.profile.maxMs[i]  = 29 * (i + 1);
+  }
+  report.profile.windowWakes = MPPT_WAKE_PROFILE_WINDOW;
+  report.energy.wakeMas      = 812.3467f;
+  for (size_t i = 0; i < ENERGY_CONSUMER_COUNT; ++i)
+    report.energy.todayMwh[i] = 10.5173f * (i + 1);
+  report.loadShare = 0.02371f;
+  return report;
+}
+
+String serialized(const JsonVariant& variant) {
+  String out;
+  serializeJson(variant, out);
+  return out;
+}
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_streaming_output_matches_the_document_path() {
+  const LogEntry entry = populatedEntry();
+  uint8_t        buffer[LogEntry::MAX_PRINT_LENGTH + 1];
+  streamJson(entry, buffer);
+  TEST_ASSERT_EQUAL_STRING(documentJson(entry).c_str(), reinterpret_cast<const char*>(buffer));
+}
+
+void test_report_output_matches_the_document_path_within_print_precision() {
+  const WakeReport report = populatedReport();
+  uint8_t          buffer[WakeReport::MAX_PRINT_LENGTH + 1];
+  BufferPrint      out(buffer, WakeReport::MAX_PRINT_LENGTH);
+  report.printJson(out);
+  buffer[out.length()] = '\0';
+
+  JsonDocument streamed, document;
+  TEST_ASSERT_FALSE(deserializeJson(streamed, reinterpret_cast<const char*>(buffer)));
+  report.toDocument(document);
+  TEST_ASSERT_EQUAL_UINT32(document["ts"].as<uint32_t>(), streamed["ts"].as<uint32_t>());
+  TEST_ASSERT_EQUAL_STRING(serialized(document["profile"]).c_str(), serialized(streamed["profile"]).c_str());
+  TEST_ASSERT_EQUAL_STRING(serialized(document["profile_window"]).c_str(),
+                           serialized(streamed["profile_window"]).c_str());
+
+  // the energy figures are printed rounded, the document holds full floats
+  const JsonVariant energy = streamed["energy"];
+  TEST_ASSERT_FLOAT_WITHIN(0.05f, report.energy.wakeMas, energy["wake_mas"].as<float>());
+  for (size_t i = 0; i < ENERGY_CONSUMER_COUNT; ++i) {
+    const float todayMwh = energy["today_mwh"][ENERGY_CONSUMER_NAMES[i]].as<float>();
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, report.energy.todayMwh[i], todayMwh);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, report.energy.todayTotalMwh(), energy["today_mwh"]["total"].as<float>());
+  TEST_ASSERT_FLOAT_WITHIN(0.0005f, report.loadShare, energy["load_share"].as<float>());
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, report.energy.wakeMas, document["energy"]["wake_mas"].as<float>());
+}
+
+void test_serializer_cost_per_entry() {
+  const LogEntry entry = populatedEntry();
+  uint8_t        buffer[LogEntry::MAX_PRINT_LENGTH + 1];
+  size_t         streamLength = 0, documentLength = 0;
+
+  const Cost stream   = measure([&] { streamLength = streamJson(entry, buffer); });
+  const Cost document = measure([&] { documentLength = documentJson(entry).length(); });
+
+  char report[192];
+  snprintf(report, sizeof(report),
+           "JsonDocument + String: %.0f ns, %llu ticks (%zu bytes); printJson: %.0f ns, %llu ticks (%zu bytes)",
+           document.ns, static_cast<unsigned long long>(document.ticks), documentLength, stream.ns,
+           static_cast<unsigned long long>(stream.ticks), streamLength);
+  TEST_MESSAGE(report);
+  TEST_ASSERT_GREATER_THAN(0, streamLength);
+  TEST_ASSERT_LESS_OR_EQUAL(LogEntry::MAX_PRINT_LENGTH, streamLength);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_streaming_output_matches_the_document_path);
+  RUN_TEST(test_report_output_matches_the_document_path_within_print_precision);
+  RUN_TEST(test_serializer_cost_per_entry);
+  return UNITY_END();
+}
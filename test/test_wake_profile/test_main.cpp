@@ -0,0 +1,93 @@
+#include <unity.h>
+
+#include "BufferPrint.h"
+#include "LoggingService.h"
+#include "NativeApp.h"
+#include "UploadEncoder.h"
+
+/**
+ * The wake profile and energy summary travel in the WakeReport of an upload, not in the stored samples: the report
+ * carries the last wake and the window statistics, and goes into the upload body as an item of its own before the
+ * entries.
+ */
+
+namespace {
+constexpr uint32_t TS = 1753296102;
+
+template <typename Item>
+String printJson(const Item& item) {
+  uint8_t     text[Item::MAX_PRINT_LENGTH + 1];
+  BufferPrint out(text, Item::MAX_PRINT_LENGTH);
+  item.printJson(out);
+  text[out.length()] = '\0';
+  return String(reinterpret_cast<const char*>(text));
+}
+
+bool contains(const String& text, const char* part) {
+  return strstr(text.c_str(), part) != nullptr;
+}
+}  // namespace
+
+void setUp() {
+  // one finished wake in the window
+  WakeProfiler::begin();
+  WakeProfiler::record(WakePhase::WakeSetup, 5000);
+  WakeProfiler::finishWake();
+}
+void tearDown() {}
+
+void test_entry_carries_no_profile() {
+  const String json = printJson(LogEntry(TS, 0));
+  TEST_ASSERT_FALSE(contains(json, "\"profile"));
+  TEST_ASSERT_FALSE(contains(json, "\"energy\""));
+}
+
+void test_report_has_the_last_wake_and_the_window() {
+  const WakeReport report = WakeReport::capture();
+  TEST_ASSERT_FALSE(report.isEmpty());
+  const String json = printJson(report);
+  TEST_ASSERT_TRUE(contains(json, "\"profile\":{\"wake_setup\":"));
+  TEST_ASSERT_TRUE(contains(json, "\"profile_window\":{\"wakes\":"));
+}
+
+void test_report_line_starts_with_the_window_size() {
+  uint8_t     text[WakeReport::MAX_PRINT_LENGTH + 1];
+  BufferPrint out(text, WakeReport::MAX_PRINT_LENGTH);
+  WakeReport::capture().printLineProtocol(out);
+  text[out.length()] = '\0';
+  const char* fields = strchr(reinterpret_cast<const char*>(text), ' ');
+  TEST_ASSERT_NOT_NULL(fields);
+  TEST_ASSERT_EQUAL_INT(0, strncmp(fields, " profile_window_wakes=", strlen(" profile_window_wakes=")));
+}
+
+void test_report_is_an_item_of_its_own_in_the_upload() {
+  JsonUploadEncoder encoder;
+  TEST_ASSERT_TRUE(encoder.begin());
+  TEST_ASSERT_TRUE(encoder.add(WakeReport::capture()));
+  TEST_ASSERT_TRUE(encoder.add(LogEntry(TS, 0)));
+  TEST_ASSERT_TRUE(encoder.add(LogEntry(TS + 120, 0)));
+  TEST_ASSERT_EQUAL_UINT32(3, encoder.count());
+
+  size_t         length = 0;
+  const uint8_t* body   = encoder.finish(length);
+  const String   json(reinterpret_cast<const char*>(body), length);
+  const char*    first = strstr(json.c_str(), "\"profile\"");
+  TEST_ASSERT_NOT_NULL(first);
+  TEST_ASSERT_NULL(strstr(first + 1, "\"profile\""));
+  TEST_ASSERT_TRUE(first < strstr(json.c_str(), "\"registers\""));
+}
+
+void test_chunks_carry_no_report() {
+  ChunkUploadEncoder encoder;
+  TEST_ASSERT_FALSE(encoder.add(WakeReport::capture()));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_entry_carries_no_profile);
+  RUN_TEST(test_report_has_the_last_wake_and_the_window);
+  RUN_TEST(test_report_line_starts_with_the_window_size);
+  RUN_TEST(test_report_is_an_item_of_its_own_in_the_upload);
+  RUN_TEST(test_chunks_carry_no_report);
+  return UNITY_END();
+}
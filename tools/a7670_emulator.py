@@ -0,0 +1,241 @@
+#!/usr/bin/env python3
+"""
+Host-side SIMCom A7670E AT command stand-in.
+
+Opens a pseudo-terminal and answers the AT dialog of CommunicationA7670E:
+power-on (the first AT after power-off), SIM, network registration, the
+power saving requests (AT+CPSMS, AT+CEDRXS) and their grant (AT+CEREG=4,
+AT+CEREG?, AT+CEDRXRDP), DTR sleep (AT+CSCLK) and power-off (AT+CPOF).
+The registration survives a DTR sleep and is lost at power-off, so a
+session after a sleep answers registered right away while a session after
+a power-off searches for --attach-ms first.
+
+A pty has no DTR line: a modem that went to sleep with AT+CSCLK=1 wakes on
+the first command after the session gap, --wake-ms later. Commands the
+emulator does not model are answered OK (ERROR with --strict). A script
+file overrides answers: one "<regex>\\t<response>" pair per line, the
+response lines separated by "\\n".
+
+Every session (a burst of commands separated by an idle gap) is summarized
+with its command count, modem-on time and whether it attached from scratch
+or reused the attachment, i.e. the figure PSM is meant to cut.
+
+Usage:
+  tools/a7670_emulator.py --link /tmp/ttyModem --attach-ms 12000
+  tools/a7670_emulator.py --link /tmp/ttyModem --reject-psm
+"""
+
+import argparse
+import os
+import pty
+import re
+import select
+import signal
+import sys
+import time
+import tty
+
+DEACTIVATED = "11100000"
+
+
+class A7670:
+    def __init__(self, args):
+        self.args = args
+        self.script = self.load_script(args.script) if args.script else []
+        self.powered = False
+        self.asleep = False
+        self.attached_at = None  # monotonic time the registration completes
+        self.attached_before = False  # registered when the session started
+        self.cereg_mode = 0
+        self.psm_requested = None  # (tau, active time)
+        self.edrx_requested = None
+        self.dtr_sleep = False
+        self.sessions = 0
+        self.reset_session()
+
+    @staticmethod
+    def load_script(path):
+        rules = []
+        with open(path, encoding="utf-8") as f:
+            for line in f:
+                line = line.rstrip("\n")
+                if not line or line.startswith("#"):
+                    continue
+                pattern, response = line.split("\t", 1)
+                rules.append((re.compile(pattern), response.replace("\\n", "\n").split("\n")))
+        return rules
+
+    # ---- statistics -------------------------------------------------------
+
+    def reset_session(self):
+        self.session_started = None
+        self.session_last = None
+        self.session_commands = 0
+
+    def account(self):
+        now = time.monotonic()
+        if self.session_started is None:
+            self.session_started = now
+            self.attached_before = self.registered()
+        self.session_last = now
+        self.session_commands += 1
+
+    def report_session(self):
+        if self.session_started is None:
+            return
+        self.sessions += 1
+        duration_ms = (self.session_last - self.session_started) * 1000.0
+        state = "off" if not self.powered else "asleep" if self.asleep else "on"
+        print("[session %d] commands=%d modem_on=%.1f ms attach=%s psm=%s -> modem %s"
+              % (self.sessions, self.session_commands, duration_ms, "reused" if self.attached_before else "full",
+                 "granted" if self.psm_granted() else "rejected", state), flush=True)
+        self.reset_session()
+
+    # ---- modem state ------------------------------------------------------
+
+    def registered(self):
+        return self.powered and self.attached_at is not None and time.monotonic() >= self.attached_at
+
+    def psm_granted(self):
+        return self.psm_requested is not None and not self.args.reject_psm
+
+    def power_on(self):
+        self.powered = True
+        self.asleep = False
+        self.attached_at = time.monotonic() + self.args.attach_ms / 1000.0
+        time.sleep(self.args.boot_ms / 1000.0)
+
+    def end_session(self):
+        """Idle gap: a modem with DTR sleep enabled falls asleep, keeping its registration."""
+        if self.powered and self.dtr_sleep:
+            self.asleep = True
+
+    def registration_report(self):
+        stat = 3 if self.args.deny else 1 if self.registered() else 2
+        fields = [str(self.cereg_mode), str(stat)]
+        if stat == 1 and self.cereg_mode >= 2:
+            fields += ['"5A1E"', '"0B28A40A"', "7"]
+            if self.cereg_mode >= 4:
+                tau, active = self.psm_requested if self.psm_granted() else (DEACTIVATED, DEACTIVATED)
+                fields += ["", "", '"%s"' % active, '"%s"' % tau]
+        return ["+CEREG: " + ",".join(fields)]
+
+    def handle(self, command):
+        for pattern, response in self.script:
+            if pattern.fullmatch(command):
+                return response
+
+        if not self.powered:
+            self.power_on()
+        elif self.asleep:
+            self.asleep = False
+            time.sleep(self.args.wake_ms / 1000.0)
+
+        if command in ("AT", "ATE0", "AT+CMEE=2") or command.startswith("AT+CGDCONT="):
+            return ["OK"]
+        if command == "AT+CPIN?":
+            return ["+CPIN: READY", "OK"]
+        if command == "AT+CSQ":
+            return ["+CSQ: %d,99" % (20 if self.registered() else 99), "OK"]
+        if command.startswith("AT+CEREG="):
+            self.cereg_mode = int(command.split("=")[1])
+            return ["OK"]
+        if command in ("AT+CEREG?", "AT+CGREG?", "AT+CREG?"):
+            return self.registration_report() + ["OK"]
+        if command == "AT+CPSI?":
+            if not self.registered():
+                return ["+CPSI: NO SERVICE,Online", "OK"]
+            return ["+CPSI: LTE,Online,231-01,0x5A1E,187214346,75,EUTRAN-BAND3,1300,5,5,-131,-1010,-781,7", "OK"]
+        match = re.fullmatch(r'AT\+CPSMS=(\d)(?:,[^,]*,[^,]*,"(\d{8})","(\d{8})")?', command)
+        if match:
+            self.psm_requested = (match.group(2), match.group(3)) if match.group(1) == "1" else None
+            return ["OK"]
+        match = re.fullmatch(r'AT\+CEDRXS=(\d),\d,"(\d{4})"', command)
+        if match:
+            self.edrx_requested = match.group(2) if match.group(1) == "1" else None
+            return ["OK"]
+        if command == "AT+CEDRXRDP":
+            if self.edrx_requested is None or self.args.reject_edrx or not self.registered():
+                return ["+CEDRXRDP: 0", "OK"]
+            return ['+CEDRXRDP: 4,"%s","%s","0011"' % (self.edrx_requested, self.edrx_requested), "OK"]
+        if command.startswith("AT+CSCLK="):
+            self.dtr_sleep = command.endswith("1")
+            return ["OK"]
+        if command == "AT+CPOF":
+            self.powered = False
+            self.attached_at = None
+            self.dtr_sleep = False
+            return ["OK"]
+        return ["ERROR" if self.args.strict else "OK"]
+
+    def respond(self, fd, command):
+        self.account()
+        response = self.handle(command)
+        if self.args.verbose:
+            print("[rx] %s -> %s" % (command, " | ".join(response)), flush=True)
+        time.sleep(self.args.latency_ms / 1000.0)
+        os.write(fd, "".join("\r\n%s\r\n" % line for line in response).encode())
+
+    def serve(self, fd):
+        buf = b""
+        while True:
+            ready, _, _ = select.select([fd], [], [], self.args.session_gap_ms / 1000.0)
+            if not ready:
+                self.end_session()
+                self.report_session()
+                continue
+            try:
+                chunk = os.read(fd, 256)
+            except OSError:
+                time.sleep(0.05)  # nothing attached to the pty yet
+                continue
+            buf += chunk
+            while b"\r" in buf:
+                line, buf = buf.split(b"\r", 1)
+                command = line.strip().decode(errors="replace")
+                if command:
+                    self.respond(fd, command)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="SIMCom A7670E AT command stand-in on a pseudo-terminal")
+    parser.add_argument("--link", help="create a symlink to the modem pty at this path")
+    parser.add_argument("--boot-ms", type=float, default=3000.0, help="power-on until the first AT is answered")
+    parser.add_argument("--attach-ms", type=float, default=15000.0, help="network search after power-on")
+    parser.add_argument("--wake-ms", type=float, default=50.0, help="DTR wake-up of a sleeping modem")
+    parser.add_argument("--latency-ms", type=float, default=5.0, help="turnaround before each response")
+    parser.add_argument("--reject-psm", action="store_true", help="the network does not grant PSM")
+    parser.add_argument("--reject-edrx", action="store_true", help="the network does not grant eDRX")
+    parser.add_argument("--deny", action="store_true", help="registration denied")
+    parser.add_argument("--strict", action="store_true", help="answer ERROR to commands that are not modelled")
+    parser.add_argument("--script", help="file of <regex>\\t<response> overrides")
+    parser.add_argument("--session-gap-ms", type=float, default=5000.0, help="idle gap that ends a session")
+    parser.add_argument("-v", "--verbose", action="store_true")
+    args = parser.parse_args()
+
+    master, slave = pty.openpty()
+    tty.setraw(master)
+    tty.setraw(slave)
+    slave_name = os.ttyname(slave)
+    if args.link:
+        if os.path.islink(args.link):
+            os.unlink(args.link)
+        os.symlink(slave_name, args.link)
+    print("A7670E emulator listening on %s%s" % (slave_name, " (%s)" % args.link if args.link else ""), flush=True)
+
+    emulator = A7670(args)
+
+    def shutdown(*_):
+        emulator.report_session()
+        print("sessions: %d" % emulator.sessions)
+        if args.link and os.path.islink(args.link):
+            os.unlink(args.link)
+        sys.exit(0)
+
+    signal.signal(signal.SIGINT, shutdown)
+    signal.signal(signal.SIGTERM, shutdown)
+    emulator.serve(master)
+
+
+if __name__ == "__main__":
+    main()
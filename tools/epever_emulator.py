@@ -0,0 +1,377 @@
+#!/usr/bin/env python3
+"""
+Host-side EPever Modbus RTU slave emulator.
+
+Opens a pseudo-terminal and answers Modbus RTU requests the way the MPPT
+controller does, using the register map from include/SolarMPPTMonitor.h:
+
+  - input registers 0x3100..0x331C            (function 0x04)
+  - holding registers 0x9013..0x9015, 0x903D  (functions 0x03, 0x06, 0x10)
+  - coil 0x0002, remote load control          (functions 0x01, 0x05)
+
+Faults can be injected to exercise the RS485 error paths: response latency
+and jitter, corrupted CRCs, dropped responses (master timeout) and Modbus
+exceptions for unmapped addresses. Every request is counted, and a summary
+per wake (a burst of requests separated by an idle gap) reports transactions,
+bytes on the wire and duration.
+
+Usage:
+  tools/epever_emulator.py --link /tmp/ttyMPPT --latency-ms 15 --crc-error-rate 0.05
+
+Then point a Modbus master (or a host build of SolarMPPTMonitor) at /tmp/ttyMPPT.
+"""
+
+import argparse
+import os
+import pty
+import random
+import select
+import signal
+import sys
+import time
+import tty
+
+# function codes
+FC_READ_COILS = 0x01
+FC_READ_HOLDING = 0x03
+FC_READ_INPUT = 0x04
+FC_WRITE_COIL = 0x05
+FC_WRITE_REGISTER = 0x06
+FC_WRITE_MULTIPLE = 0x10
+
+# exception codes
+EX_ILLEGAL_FUNCTION = 0x01
+EX_ILLEGAL_ADDRESS = 0x02
+EX_ILLEGAL_VALUE = 0x03
+
+COIL_LOAD = 0x0002
+HR_RTC_SECOND_MINUTE = 0x9013
+HR_RTC_HOUR_DAY = 0x9014
+HR_RTC_MONTH_YEAR = 0x9015
+HR_LOAD_CONTROL_MODE = 0x903D
+
+
+def crc16(data: bytes) -> int:
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def with_crc(frame: bytes) -> bytes:
+    crc = crc16(frame)
+    return frame + bytes((crc & 0xFF, crc >> 8))
+
+
+def u32(value: int) -> list:
+    """EPever stores 32-bit values low word first."""
+    value &= 0xFFFFFFFF
+    return [value & 0xFFFF, value >> 16]
+
+
+def default_input_registers() -> dict:
+    """Plausible daytime values, raw words as the controller reports them."""
+    regs = {}
+
+    def put(address, words):
+        for i, w in enumerate(words):
+            regs[address + i] = w & 0xFFFF
+
+    put(0x3100, [1842])              # PV voltage 18.42 V
+    put(0x3101, [215])               # PV current 2.15 A
+    put(0x3102, u32(3960))           # PV power 39.60 W
+    put(0x3108, [1261])              # battery voltage 12.61 V
+    put(0x3109, [298])               # battery current 2.98 A
+    put(0x310A, u32(3758))           # battery power 37.58 W
+    put(0x310C, [1258])              # load voltage
+    put(0x310D, [42])                # load current
+    put(0x310E, u32(528))            # load power
+    put(0x3110, [2150])              # remote battery temperature 21.50 C
+    put(0x3111, [2875])              # equipment temperature
+    put(0x3112, [3010])              # MOSFET temperature
+    put(0x311A, [87])                # battery SOC %
+    put(0x3200, [0x0000])            # battery status
+    put(0x3201, [0x0005])            # charging status
+    put(0x3202, [0x0001])            # discharging status
+    put(0x3300, [2012])              # max PV voltage today
+    put(0x3301, [0])                 # min PV voltage today
+    put(0x3302, [1388])              # max battery voltage today
+    put(0x3303, [1212])              # min battery voltage today
+    put(0x3304, u32(12))             # consumed energy today
+    put(0x3306, u32(310))
+    put(0x3308, u32(2650))
+    put(0x330A, u32(4120))
+    put(0x330C, u32(18))             # generated energy today
+    put(0x330E, u32(420))
+    put(0x3310, u32(3320))
+    put(0x3312, u32(5010))
+    put(0x331B, u32(-135))           # battery current -1.35 A (S32)
+    return regs
+
+
+class EPeverSlave:
+    def __init__(self, args):
+        self.args = args
+        self.rng = random.Random(args.seed)
+        self.input_registers = default_input_registers()
+        self.holding_registers = {HR_LOAD_CONTROL_MODE: 0}
+        self.rtc_offset = 0  # seconds between emulated RTC and host clock
+        self.coils = {COIL_LOAD: 0}
+        self.reset_wake()
+        self.total_transactions = 0
+
+    # ---- statistics -------------------------------------------------------
+
+    def reset_wake(self):
+        self.wake_started = None
+        self.wake_last = None
+        self.wake_transactions = 0
+        self.wake_bytes_rx = 0
+        self.wake_bytes_tx = 0
+        self.wake_faults = 0
+        self.wake_by_function = {}
+
+    def account(self, function, rx, tx, fault):
+        now = time.monotonic()
+        if self.wake_started is None:
+            self.wake_started = now
+        self.wake_last = now
+        self.wake_transactions += 1
+        self.total_transactions += 1
+        self.wake_bytes_rx += rx
+        self.wake_bytes_tx += tx
+        self.wake_faults += 1 if fault else 0
+        self.wake_by_function[function] = self.wake_by_function.get(function, 0) + 1
+
+    def report_wake(self):
+        if self.wake_started is None:
+            return
+        duration_ms = (self.wake_last - self.wake_started) * 1000.0
+        per_fc = ", ".join("0x%02X=%d" % (fc, n) for fc, n in sorted(self.wake_by_function.items()))
+        print("[wake] transactions=%d (%s) faults=%d bytes rx=%d tx=%d wire=%d duration=%.1f ms"
+              % (self.wake_transactions, per_fc, self.wake_faults, self.wake_bytes_rx, self.wake_bytes_tx,
+                 self.wake_bytes_rx + self.wake_bytes_tx, duration_ms), flush=True)
+        self.reset_wake()
+
+    # ---- register access --------------------------------------------------
+
+    def rtc_words(self):
+        t = time.localtime(time.time() + self.rtc_offset)
+        return {
+            HR_RTC_SECOND_MINUTE: (t.tm_min << 8) | t.tm_sec,
+            HR_RTC_HOUR_DAY: (t.tm_mday << 8) | t.tm_hour,
+            HR_RTC_MONTH_YEAR: ((t.tm_year - 2000) << 8) | t.tm_mon,
+        }
+
+    def read_input(self, address):
+        if address in self.input_registers:
+            return self.input_registers[address]
+        if self.args.strict_map:
+            return None
+        return 0
+
+    def read_holding(self, address):
+        rtc = self.rtc_words()
+        if address in rtc:
+            return rtc[address]
+        return self.holding_registers.get(address)
+
+    def write_holding(self, address, value):
+        if address in (HR_RTC_SECOND_MINUTE, HR_RTC_HOUR_DAY, HR_RTC_MONTH_YEAR):
+            self.holding_registers[address] = value
+            if all(a in self.holding_registers for a in (HR_RTC_SECOND_MINUTE, HR_RTC_HOUR_DAY, HR_RTC_MONTH_YEAR)):
+                self.apply_rtc()
+            return True
+        if address == HR_LOAD_CONTROL_MODE:
+            self.holding_registers[address] = value
+            return True
+        return False
+
+    def apply_rtc(self):
+        sm = self.holding_registers.pop(HR_RTC_SECOND_MINUTE)
+        hd = self.holding_registers.pop(HR_RTC_HOUR_DAY)
+        my = self.holding_registers.pop(HR_RTC_MONTH_YEAR)
+        try:
+            target = time.mktime((2000 + (my >> 8), my & 0xFF, hd >> 8, hd & 0xFF, sm >> 8, sm & 0xFF, 0, 0, -1))
+            self.rtc_offset = target - time.time()
+        except (OverflowError, ValueError):
+            pass
+
+    # ---- protocol ---------------------------------------------------------
+
+    @staticmethod
+    def expected_length(buf: bytes):
+        """Length of the request frame at the start of buf, None if more bytes are needed."""
+        if len(buf) < 2:
+            return None
+        function = buf[1]
+        if function in (FC_READ_COILS, FC_READ_HOLDING, FC_READ_INPUT, FC_WRITE_COIL, FC_WRITE_REGISTER):
+            return 8
+        if function == FC_WRITE_MULTIPLE:
+            if len(buf) < 7:
+                return None
+            return 9 + buf[6]
+        return len(buf)  # unknown function, consume what we have and answer with an exception
+
+    @staticmethod
+    def exception(slave, function, code):
+        return with_crc(bytes((slave, function | 0x80, code)))
+
+    def handle(self, frame: bytes):
+        slave, function = frame[0], frame[1]
+        if len(frame) < 4 or crc16(frame[:-2]) != (frame[-2] | frame[-1] << 8):
+            print("[rx] bad CRC, ignoring %s" % frame.hex(), flush=True)
+            return None
+        if slave != self.args.slave_id:
+            return None
+
+        if function in (FC_READ_INPUT, FC_READ_HOLDING):
+            start = frame[2] << 8 | frame[3]
+            count = frame[4] << 8 | frame[5]
+            if count < 1 or count > 125:
+                return self.exception(slave, function, EX_ILLEGAL_VALUE)
+            reader = self.read_input if function == FC_READ_INPUT else self.read_holding
+            words = [reader(start + i) for i in range(count)]
+            if any(w is None for w in words):
+                return self.exception(slave, function, EX_ILLEGAL_ADDRESS)
+            payload = b"".join(bytes((w >> 8, w & 0xFF)) for w in words)
+            return with_crc(bytes((slave, function, len(payload))) + payload)
+
+        if function == FC_READ_COILS:
+            start = frame[2] << 8 | frame[3]
+            count = frame[4] << 8 | frame[5]
+            if count < 1 or count > 2000:
+                return self.exception(slave, function, EX_ILLEGAL_VALUE)
+            bits = [self.coils.get(start + i) for i in range(count)]
+            if any(b is None for b in bits):
+                return self.exception(slave, function, EX_ILLEGAL_ADDRESS)
+            packed = bytearray((count + 7) // 8)
+            for i, b in enumerate(bits):
+                if b:
+                    packed[i // 8] |= 1 << (i % 8)
+            return with_crc(bytes((slave, function, len(packed))) + bytes(packed))
+
+        if function == FC_WRITE_COIL:
+            address = frame[2] << 8 | frame[3]
+            value = frame[4] << 8 | frame[5]
+            if address not in self.coils:
+                return self.exception(slave, function, EX_ILLEGAL_ADDRESS)
+            if value not in (0x0000, 0xFF00):
+                return self.exception(slave, function, EX_ILLEGAL_VALUE)
+            self.coils[address] = 1 if value == 0xFF00 else 0
+            print("[coil] 0x%04X <- %d" % (address, self.coils[address]), flush=True)
+            return frame
+
+        if function == FC_WRITE_REGISTER:
+            address = frame[2] << 8 | frame[3]
+            value = frame[4] << 8 | frame[5]
+            if not self.write_holding(address, value):
+                return self.exception(slave, function, EX_ILLEGAL_ADDRESS)
+            return frame
+
+        if function == FC_WRITE_MULTIPLE:
+            start = frame[2] << 8 | frame[3]
+            count = frame[4] << 8 | frame[5]
+            if frame[6] != count * 2:
+                return self.exception(slave, function, EX_ILLEGAL_VALUE)
+            for i in range(count):
+                value = frame[7 + 2 * i] << 8 | frame[8 + 2 * i]
+                if not self.write_holding(start + i, value):
+                    return self.exception(slave, function, EX_ILLEGAL_ADDRESS)
+            return with_crc(frame[:6])
+
+        return self.exception(slave, function, EX_ILLEGAL_FUNCTION)
+
+    def respond(self, fd, frame: bytes):
+        response = self.handle(frame)
+        fault = False
+        if response is not None:
+            if self.rng.random() < self.args.timeout_rate:
+                print("[fault] dropping response to 0x%02X" % frame[1], flush=True)
+                response, fault = None, True
+            elif self.rng.random() < self.args.crc_error_rate:
+                print("[fault] corrupting CRC of response to 0x%02X" % frame[1], flush=True)
+                response, fault = response[:-1] + bytes((response[-1] ^ 0xFF,)), True
+
+        self.account(frame[1], len(frame), len(response) if response else 0, fault)
+        if response is None:
+            return
+
+        latency = self.args.latency_ms + self.rng.uniform(0, self.args.jitter_ms)
+        # emulate time on the wire so pty timing resembles the real bus
+        wire = len(response) * 10.0 / self.args.baud * 1000.0
+        time.sleep((latency + wire) / 1000.0)
+        os.write(fd, response)
+        if self.args.verbose:
+            print("[tx] %s" % response.hex(), flush=True)
+
+    def serve(self, fd):
+        buf = b""
+        while True:
+            ready, _, _ = select.select([fd], [], [], self.args.wake_gap_ms / 1000.0)
+            if not ready:
+                if buf:
+                    print("[rx] discarding incomplete frame %s" % buf.hex(), flush=True)
+                    buf = b""
+                self.report_wake()
+                continue
+            try:
+                chunk = os.read(fd, 256)
+            except OSError:
+                time.sleep(0.05)  # no master attached to the pty yet
+                continue
+            buf += chunk
+            while True:
+                length = self.expected_length(buf)
+                if length is None or len(buf) < length:
+                    break
+                frame, buf = buf[:length], buf[length:]
+                if self.args.verbose:
+                    print("[rx] %s" % frame.hex(), flush=True)
+                self.respond(fd, frame)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="EPever Modbus RTU slave emulator on a pseudo-terminal")
+    parser.add_argument("--link", help="create a symlink to the slave pty at this path")
+    parser.add_argument("--slave-id", type=int, default=1)
+    parser.add_argument("--baud", type=int, default=115200, help="used to emulate time on the wire")
+    parser.add_argument("--latency-ms", type=float, default=5.0, help="controller turnaround before responding")
+    parser.add_argument("--jitter-ms", type=float, default=0.0, help="random extra latency, uniform")
+    parser.add_argument("--crc-error-rate", type=float, default=0.0, help="probability of a corrupted response CRC")
+    parser.add_argument("--timeout-rate", type=float, default=0.0, help="probability of not answering at all")
+    parser.add_argument("--strict-map", action="store_true",
+                        help="answer illegal data address for unmapped input registers instead of zero")
+    parser.add_argument("--wake-gap-ms", type=float, default=1000.0, help="idle gap that ends a wake summary")
+    parser.add_argument("--seed", type=int, default=None)
+    parser.add_argument("-v", "--verbose", action="store_true")
+    args = parser.parse_args()
+
+    master, slave = pty.openpty()
+    tty.setraw(master)
+    tty.setraw(slave)
+    slave_name = os.ttyname(slave)
+    if args.link:
+        if os.path.islink(args.link):
+            os.unlink(args.link)
+        os.symlink(slave_name, args.link)
+    print("EPever emulator listening on %s%s" % (slave_name, " (%s)" % args.link if args.link else ""), flush=True)
+
+    emulator = EPeverSlave(args)
+
+    def shutdown(*_):
+        emulator.report_wake()
+        print("total transactions: %d" % emulator.total_transactions)
+        if args.link and os.path.islink(args.link):
+            os.unlink(args.link)
+        sys.exit(0)
+
+    signal.signal(signal.SIGINT, shutdown)
+    signal.signal(signal.SIGTERM, shutdown)
+    emulator.serve(master)
+
+
+if __name__ == "__main__":
+    main()
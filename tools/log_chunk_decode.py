@@ -0,0 +1,266 @@
+#!/usr/bin/env python3
+"""
+Reference decoder for the columnar log chunks ("MC") written by LogChunkEncoder.
+
+Expands a chunk into one JSON object per sample, laid out like
+LogEntry::printJson(): the same keys in the same order, registers by address as
+mpptReadPlan reads them, so a backend can forward them to Telegraf unchanged.
+The wake report (profile and energy summary) is not part of a chunk.
+
+Chunk layout (all varints are unsigned LEB128):
+
+  "MC" | version (1 or 2) | device id, firmware version (u8 length + bytes each)
+  sample count (varint) | register count (u8)
+  register count x [ address (u16 LE) | type << 4 | decimals (u8) ]
+  columns: ts, load_status, signal, total_wake_time, modem_sync_time,
+           validity mask, one per register, rs485 tx, timeout, crc,
+           exception, reset, skipped, breaker, and from version 2 on
+           radio reg, access, mcc, mnc, area, cell, rsrp, rsrq, sinr
+
+Each column is the first value as a zig-zag varint, followed by tokens until
+it has one value per sample:
+
+  token & 1 == 0   delta to the previous value, zig-zag encoded in token >> 1
+  token & 1 == 1   the previous delta repeats token >> 1 times
+                   (the delta before the first token counts as 0)
+
+Register columns hold the signed register value; values whose bit in the
+validity mask is clear are dropped. Scaling is value / 10^decimals. Radio
+levels the modem did not report hold -32768 and are dropped as well.
+
+Usage:
+  tools/log_chunk_decode.py chunk.bin
+  tools/log_chunk_decode.py --self-test    # encode / decode round trip
+"""
+
+import argparse
+import json
+import sys
+
+MAGIC = b"MC"
+VERSIONS = (1, 2)
+LINK_KEYS = ["tx", "timeout", "crc", "exception", "reset", "skipped", "breaker"]
+RADIO_KEYS = ["reg", "access", "mcc", "mnc", "area", "cell", "rsrp", "rsrq", "sinr"]
+RADIO_LEVELS = ("rsrp", "rsrq", "sinr")
+NOT_REPORTED = -32768
+ENTRY_COLUMNS = 6
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def byte(self):
+        if self.pos >= len(self.data):
+            raise ValueError("chunk truncated")
+        value = self.data[self.pos]
+        self.pos += 1
+        return value
+
+    def text(self):
+        length = self.byte()
+        value = self.data[self.pos:self.pos + length]
+        if len(value) != length:
+            raise ValueError("chunk truncated")
+        self.pos += length
+        return value.decode()
+
+    def varint(self):
+        value, shift = 0, 0
+        while True:
+            b = self.byte()
+            value |= (b & 0x7F) << shift
+            if b < 0x80:
+                return value
+            shift += 7
+
+
+def zigzag(value):
+    return (value << 1) ^ (value >> 63)
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def decode_column(reader, count):
+    values = [unzigzag(reader.varint())]
+    delta = 0
+    while len(values) < count:
+        token = reader.varint()
+        if token & 1:
+            for _ in range(token >> 1):
+                values.append(values[-1] + delta)
+        else:
+            delta = unzigzag(token >> 1)
+            values.append(values[-1] + delta)
+    if len(values) != count:
+        raise ValueError("column overruns the sample count")
+    return values
+
+
+def encode_column(values):
+    out = bytearray()
+    put_varint(out, zigzag(values[0]))
+    delta, repeats = 0, 0
+    for previous, value in zip(values, values[1:]):
+        if value - previous == delta:
+            repeats += 1
+            continue
+        if repeats:
+            put_varint(out, repeats << 1 | 1)
+        delta, repeats = value - previous, 0
+        put_varint(out, zigzag(delta) << 1)
+    if repeats:
+        put_varint(out, repeats << 1 | 1)
+    return bytes(out)
+
+
+def put_varint(out, value):
+    while value >= 0x80:
+        out.append(value & 0x7F | 0x80)
+        value >>= 7
+    out.append(value)
+
+
+def format_value(value, decimals):
+    """Exact fixed-point text, like formatRegisterValue() in the firmware."""
+    if decimals <= 0:
+        return str(value)
+    sign = "-" if value < 0 else ""
+    whole, frac = divmod(abs(value), 10 ** decimals)
+    return "%s%d.%0*d" % (sign, whole, decimals, frac)
+
+
+def decode_chunk(data):
+    reader = Reader(data)
+    if bytes([reader.byte(), reader.byte()]) != MAGIC:
+        raise ValueError("not a log chunk")
+    version = reader.byte()
+    if version not in VERSIONS:
+        raise ValueError("unsupported chunk version %d" % version)
+    device_id = reader.text()
+    firmware = reader.text()
+    count = reader.varint()
+    registers = []
+    for _ in range(reader.byte()):
+        address = reader.byte() | reader.byte() << 8
+        registers.append((address, reader.byte() & 0x0F))
+
+    radio_keys = RADIO_KEYS if version >= 2 else []
+    link_start = ENTRY_COLUMNS + len(registers)
+    columns = [decode_column(reader, count) for _ in range(link_start + len(LINK_KEYS) + len(radio_keys))]
+    link_columns = columns[link_start:link_start + len(LINK_KEYS)]
+    radio_columns = columns[link_start + len(LINK_KEYS):]
+
+    # the header lists the registers in table order, printJson() prints them sorted by address
+    by_address = sorted(range(len(registers)), key=lambda index: registers[index][0])
+    entries = []
+    for i in range(count):
+        mask = columns[5][i]
+        values = {}
+        for index in by_address:
+            address, decimals = registers[index]
+            if mask >> index & 1:
+                values["0x%04X" % address] = format_value(columns[ENTRY_COLUMNS + index][i], decimals)
+        link = {key: column[i] for key, column in zip(LINK_KEYS, link_columns)}
+        link["breaker"] = bool(link["breaker"])
+        radio = {key: column[i] for key, column in zip(radio_keys, radio_columns)
+                 if key not in RADIO_LEVELS or column[i] != NOT_REPORTED}
+        entry = {
+            "ts": columns[0][i],
+            "device_id": device_id,
+            "signal": columns[2][i],
+            "total_wake_time": columns[3][i],
+            "load_status": columns[1][i],
+            "modem_sync_time": columns[4][i],
+            "firmware_version": firmware,
+            "registers": values,
+            "rs485": link,
+        }
+        if radio_keys:
+            entry["radio"] = radio
+        entries.append(entry)
+    return entries
+
+
+def to_json(entry):
+    """Serializes like the firmware: register values as bare fixed-point numbers."""
+    registers = ",".join('"%s":%s' % (key, value) for key, value in entry["registers"].items())
+    head = {key: value for key, value in entry.items() if key not in ("registers", "rs485", "radio")}
+    text = json.dumps(head, separators=(",", ":"))[:-1]
+    text = '%s,"registers":{%s},"rs485":%s' % (text, registers, json.dumps(entry["rs485"], separators=(",", ":")))
+    if "radio" in entry:
+        text += ',"radio":%s' % json.dumps(entry["radio"], separators=(",", ":"))
+    return text + "}"
+
+
+def self_test():
+    """Round trip of columns and of a whole chunk through encode_column() and decode_chunk()."""
+    columns = [
+        [7],
+        [5, 5, 5, 5],
+        [0, 1, 2, 3, 4, 10, 16, 22],
+        [1753296102 + 900 * i for i in range(240)],
+        [0, -1, 1, -(1 << 31), (1 << 31) - 1, 3, 3],
+        [NOT_REPORTED, -1010, -1010, NOT_REPORTED],
+    ]
+    for values in columns:
+        decoded = decode_column(Reader(encode_column(values)), len(values))
+        assert decoded == values, "column %r decoded as %r" % (values, decoded)
+
+    # registers out of address order, 0x3101 invalid in the second sample, rsrq not reported
+    registers = [(0x3200, 0, 0), (0x3100, 2, 0), (0x3101, 2, 0), (0x311A, 0, 0)]
+    chunk = bytearray(MAGIC + bytes([2]))
+    for text in ("crss", "1.1.6"):
+        chunk += bytes([len(text)]) + text.encode()
+    put_varint(chunk, 2)
+    chunk.append(len(registers))
+    for address, decimals, kind in registers:
+        chunk += bytes([address & 0xFF, address >> 8, kind << 4 | decimals])
+    columns = [[1753296102, 1753297002], [1, 0], [64, -1], [3800, 3830], [1753295700, 1753295700], [0b1111, 0b1011],
+               [2, 0], [1261, 1269], [52, 0], [87, 86],
+               [3, 4], [0, 1], [0, 0], [0, 0], [0, 0], [0, 0], [0, 1],
+               [1, 1], [3, 3], [231, 231], [1, 1], [0x5A1E, 0x5A1E], [187214346, 187214346], [-1010, -1010],
+               [NOT_REPORTED, -781], [7, 7]]
+    for column in columns:
+        chunk += encode_column(column)
+
+    expected = [
+        '{"ts":1753296102,"device_id":"crss","signal":64,"total_wake_time":3800,"load_status":1,'
+        '"modem_sync_time":1753295700,"firmware_version":"1.1.6",'
+        '"registers":{"0x3100":12.61,"0x3101":0.52,"0x311A":87,"0x3200":2},'
+        '"rs485":{"tx":3,"timeout":0,"crc":0,"exception":0,"reset":0,"skipped":0,"breaker":false},'
+        '"radio":{"reg":1,"access":3,"mcc":231,"mnc":1,"area":23070,"cell":187214346,"rsrp":-1010,"sinr":7}}',
+        '{"ts":1753297002,"device_id":"crss","signal":-1,"total_wake_time":3830,"load_status":0,'
+        '"modem_sync_time":1753295700,"firmware_version":"1.1.6",'
+        '"registers":{"0x3100":12.69,"0x311A":86,"0x3200":0},'
+        '"rs485":{"tx":4,"timeout":1,"crc":0,"exception":0,"reset":0,"skipped":0,"breaker":true},'
+        '"radio":{"reg":1,"access":3,"mcc":231,"mnc":1,"area":23070,"cell":187214346,"rsrp":-1010,"rsrq":-781,'
+        '"sinr":7}}',
+    ]
+    decoded = [to_json(entry) for entry in decode_chunk(bytes(chunk))]
+    for want, got in zip(expected, decoded):
+        assert want == got, "chunk decoded as\n  %s\nexpected\n  %s" % (got, want)
+    assert len(decoded) == len(expected)
+    print("self-test passed")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("chunk", nargs="?", help="chunk file, stdin if omitted")
+    parser.add_argument("--self-test", action="store_true", help="check the encoder and decoder against each other")
+    args = parser.parse_args()
+
+    if args.self_test:
+        self_test()
+        return
+
+    data = open(args.chunk, "rb").read() if args.chunk else sys.stdin.buffer.read()
+    for entry in decode_chunk(data):
+        print(to_json(entry))
+
+
+if __name__ == "__main__":
+    main()
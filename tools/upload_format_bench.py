@@ -0,0 +1,272 @@
+#!/usr/bin/env python3
+"""
+Host-side benchmark for the telemetry upload body.
+
+Builds batches of log entries (register map parsed from
+include/MPPTRegisters.h, values following a slow random walk the way a solar
+installation does across 2-minute samples) in each upload format and reports,
+per batch size, the body size uncompressed and gzip-compressed, the
+compression ratio and the CPU time to encode and to compress a batch.
+Formats:
+
+  json     JSON array of LogEntry::printJson() objects
+  line     InfluxDB line protocol, LogEntry::printLineProtocol()
+  msgpack  MessagePack array of LogEntry::toDocument() maps with numeric
+           registers, packed the way ArduinoJson's serializeMsgPack() does
+           (whole numbers as integers, the rest as 32-bit floats)
+  cbor     the same maps as CBOR; for comparison only, the firmware has no
+           CBOR serializer
+  chunk    columnar LogChunkEncoder chunk (tools/log_chunk_decode.py)
+
+The firmware uses the deflate compressor in the ESP32 ROM with the default
+128 probes, which is roughly zlib level 6 (the default here). CPU times are
+host times: they compare settings, they do not predict the ESP32.
+
+Usage:
+  tools/upload_format_bench.py --batches 1 10 30 --level 6
+"""
+
+import argparse
+import gzip
+import os
+import random
+import re
+import struct
+import time
+from collections import OrderedDict
+
+from log_chunk_decode import LINK_KEYS, RADIO_KEYS, encode_column, format_value, put_varint, to_json
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+REGISTERS_HEADER = os.path.join(ROOT, "include", "MPPTRegisters.h")
+
+REGISTER_RE = re.compile(r'\{(0x[0-9A-Fa-f]{4}),\s*"[^"]*",\s*([0-9.]+)f,\s*REG_(U16|U32|S16|S32)\}')
+REG_TYPES = {"U16": 0, "U32": 1, "S16": 2, "S32": 3}
+
+
+def decimals(scale):
+    d = 0
+    while scale < 1.0 and d < 6:
+        scale *= 10
+        d += 1
+    return d
+
+
+def load_registers():
+    with open(REGISTERS_HEADER, encoding="utf-8") as f:
+        return [(int(addr, 16), decimals(float(scale)), kind) for addr, scale, kind in REGISTER_RE.findall(f.read())]
+
+
+def make_entries(registers, count, seed):
+    """Entries with raw integer register values; most registers drift slowly or stay unchanged between samples."""
+    rng = random.Random(seed)
+    raw = {addr: rng.randint(0, 2000) for addr, _, _ in registers}
+    ts = 1753296102
+    entries = []
+    for i in range(count):
+        values = {}
+        for addr, _, _ in registers:
+            if rng.random() < 0.4:
+                raw[addr] = max(0, raw[addr] + rng.randint(-15, 15))
+            values[addr] = raw[addr]
+        entries.append({
+            "ts": ts + i * 120,
+            "device_id": "crss",
+            "signal": 64,
+            "total_wake_time": 3821 + i * 4,
+            "load_status": 1,
+            "modem_sync_time": 1753295700,
+            "firmware_version": "1.1.6",
+            "registers": values,
+            "rs485": {"tx": 3, "timeout": 0, "crc": 0, "exception": 0, "reset": 0, "skipped": 0, "breaker": False},
+            "radio": {"reg": 1, "access": 3, "mcc": 231, "mnc": 1, "area": 23070, "cell": 187214346, "rsrp": -1010,
+                      "rsrq": -131, "sinr": 7},
+        })
+    return entries
+
+
+def json_body(entries, registers):
+    lines = []
+    for entry in entries:
+        regs = {"0x%04X" % addr: format_value(entry["registers"][addr], dec) for addr, dec, _ in registers}
+        lines.append(to_json(dict(entry, registers=regs)))
+    return ("[" + ",".join(lines) + "]").encode()
+
+
+def line_body(entries, registers):
+    lines = []
+    for entry in entries:
+        regs = "".join(",0x%04X=%s" % (addr, format_value(entry["registers"][addr], dec)) for addr, dec, _ in registers)
+        link = "".join(",rs485_%s=%s" % (key, str(value).lower() if key == "breaker" else "%di" % value)
+                       for key, value in entry["rs485"].items())
+        radio = "".join(",radio_%s=%di" % (key, value) for key, value in entry["radio"].items())
+        lines.append("mppt,device_id=%s,firmware_version=%s signal=%di,total_wake_time=%di,load_status=%di,"
+                     "modem_sync_time=%di%s%s%s %d\n" % (entry["device_id"], entry["firmware_version"], entry["signal"],
+                                                        entry["total_wake_time"], entry["load_status"],
+                                                        entry["modem_sync_time"], regs, link, radio, entry["ts"]))
+    return "".join(lines).encode()
+
+
+def numeric_entry(entry, registers):
+    """The LogEntry::toDocument(doc, true) map: scaled register values stored as float."""
+    doc = OrderedDict((k, v) for k, v in entry.items() if k not in ("registers", "rs485", "radio"))
+    doc["registers"] = OrderedDict(("0x%04X" % addr, struct.unpack("<f", struct.pack("<f", value / 10 ** dec))[0])
+                                   for addr, dec, _ in registers for value in [entry["registers"][addr]])
+    doc["rs485"] = entry["rs485"]
+    doc["radio"] = entry["radio"]
+    return doc
+
+
+def pack_uint(out, value, sizes):
+    """Marker byte and value in the shortest of the (marker, struct format, limit) widths that fits."""
+    for marker, fmt, limit in sizes:
+        if value <= limit:
+            out.append(marker)
+            out += struct.pack(fmt, value)
+            return
+    raise ValueError("value too large")
+
+
+def msgpack(out, value):
+    if isinstance(value, bool):
+        out.append(0xC3 if value else 0xC2)
+    elif isinstance(value, float) and value != int(value):
+        out.append(0xCA)
+        out += struct.pack(">f", value)
+    elif isinstance(value, (int, float)):
+        value = int(value)
+        if -32 <= value < 128:
+            out += struct.pack(">b", value)
+        elif value >= 0:
+            pack_uint(out, value, [(0xCC, ">B", 0xFF), (0xCD, ">H", 0xFFFF), (0xCE, ">I", 0xFFFFFFFF)])
+        else:
+            for marker, fmt, bits in [(0xD0, ">b", 8), (0xD1, ">h", 16), (0xD2, ">i", 32)]:
+                if value >= -(1 << (bits - 1)):
+                    out.append(marker)
+                    out += struct.pack(fmt, value)
+                    break
+    elif isinstance(value, str):
+        data = value.encode()
+        if len(data) < 32:
+            out.append(0xA0 | len(data))
+        else:
+            pack_uint(out, len(data), [(0xD9, ">B", 0xFF), (0xDA, ">H", 0xFFFF)])
+        out += data
+    elif isinstance(value, dict):
+        if len(value) < 16:
+            out.append(0x80 | len(value))
+        else:
+            pack_uint(out, len(value), [(0xDE, ">H", 0xFFFF)])
+        for key, item in value.items():
+            msgpack(out, key)
+            msgpack(out, item)
+    else:
+        raise TypeError(type(value))
+
+
+def cbor_head(out, major, value):
+    if value < 24:
+        out.append(major << 5 | value)
+    else:
+        pack_uint(out, value, [(major << 5 | 24, ">B", 0xFF), (major << 5 | 25, ">H", 0xFFFF),
+                               (major << 5 | 26, ">I", 0xFFFFFFFF)])
+
+
+def cbor(out, value):
+    if isinstance(value, bool):
+        out.append(0xF5 if value else 0xF4)
+    elif isinstance(value, float) and value != int(value):
+        out.append(0xFA)
+        out += struct.pack(">f", value)
+    elif isinstance(value, (int, float)):
+        value = int(value)
+        if value >= 0:
+            cbor_head(out, 0, value)
+        else:
+            cbor_head(out, 1, -1 - value)
+    elif isinstance(value, str):
+        data = value.encode()
+        cbor_head(out, 3, len(data))
+        out += data
+    elif isinstance(value, dict):
+        cbor_head(out, 5, len(value))
+        for key, item in value.items():
+            cbor(out, key)
+            cbor(out, item)
+    else:
+        raise TypeError(type(value))
+
+
+def msgpack_body(entries, registers):
+    out = bytearray(struct.pack(">BI", 0xDD, len(entries)))  # array32, as MsgPackUploadEncoder writes it
+    for entry in entries:
+        msgpack(out, numeric_entry(entry, registers))
+    return bytes(out)
+
+
+def cbor_body(entries, registers):
+    out = bytearray()
+    cbor_head(out, 4, len(entries))
+    for entry in entries:
+        cbor(out, numeric_entry(entry, registers))
+    return bytes(out)
+
+
+def chunk_body(entries, registers):
+    """Same layout as LogChunkEncoder (see tools/log_chunk_decode.py)."""
+    out = bytearray(b"MC\x02")
+    for text in (entries[0]["device_id"], entries[0]["firmware_version"]):
+        out += bytes([len(text)]) + text.encode()
+    put_varint(out, len(entries))
+    out.append(len(registers))
+    for addr, dec, kind in registers:
+        out += struct.pack("<HB", addr, REG_TYPES[kind] << 4 | dec)
+    columns = [[e["ts"] for e in entries], [e["load_status"] for e in entries], [e["signal"] for e in entries],
+               [e["total_wake_time"] for e in entries], [e["modem_sync_time"] for e in entries],
+               [(1 << len(registers)) - 1] * len(entries)]
+    columns += [[e["registers"][addr] for e in entries] for addr, _, _ in registers]
+    columns += [[int(e["rs485"][key]) for e in entries] for key in LINK_KEYS]
+    columns += [[e["radio"][key] for e in entries] for key in RADIO_KEYS]
+    for column in columns:
+        out += encode_column(column)
+    return bytes(out)
+
+
+FORMATS = {
+    "json": json_body,
+    "line": line_body,
+    "msgpack": msgpack_body,
+    "cbor": cbor_body,
+    "chunk": chunk_body,
+}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--batches", type=int, nargs="+", default=[1, 10, 30, 240], help="entries per batch")
+    parser.add_argument("--level", type=int, default=6, help="deflate level")
+    parser.add_argument("--rounds", type=int, default=50, help="compressions per measurement")
+    parser.add_argument("--format", choices=sorted(FORMATS), nargs="+", default=sorted(FORMATS))
+    args = parser.parse_args()
+
+    registers = load_registers()
+    print("%d registers from %s" % (len(registers), os.path.relpath(REGISTERS_HEADER, ROOT)))
+    print("%-8s %6s %10s %10s %7s %15s %14s" % ("format", "batch", "raw B", "gzip B", "ratio", "encode us/batch",
+                                                "gzip us/batch"))
+    for fmt in args.format:
+        for size in args.batches:
+            entries = make_entries(registers, size, seed=size)
+            start = time.process_time()
+            for _ in range(args.rounds):
+                body = FORMATS[fmt](entries, registers)
+            encode_us = (time.process_time() - start) / args.rounds * 1e6
+            start = time.process_time()
+            for _ in range(args.rounds):
+                packed = gzip.compress(body, compresslevel=args.level, mtime=0)
+            gzip_us = (time.process_time() - start) / args.rounds * 1e6
+            print("%-8s %6d %10d %10d %6.1fx %15.0f %14.0f" % (fmt, size, len(body), len(packed),
+                                                               len(body) / len(packed), encode_us, gzip_us))
+
+
+if __name__ == "__main__":
+    main()